@@ -0,0 +1,385 @@
+// whisper-server-bench
+//
+// Reproducible load/latency benchmark for the whisper server. Drives the
+// /inference and /stream endpoints over HTTP at configurable concurrency,
+// or calls whisper_full directly (--direct) to take the HTTP stack out of
+// the measurement. Audio comes from a recorded WAV (--file) or a synthetic
+// tone corpus (--duration). Reports p50/p95/p99 latency, aggregate RTF and
+// peak RSS so tuning changes (threads, workers, flash_attn, beam size)
+// are validated against numbers instead of vibes.
+//
+// Examples:
+//   whisper-server-bench --mode inference --port 8178 --duration 10 -c 4 -n 32
+//   whisper-server-bench --mode stream --file meeting.wav -c 8 -n 64
+//   whisper-server-bench --mode direct -m models/ggml-base.en.bin --duration 30 -n 8
+
+#define _USE_MATH_DEFINES // for M_PI on MSVC
+
+#include "common.h"
+#include "whisper.h"
+#include "httplib.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+struct bench_params {
+    std::string mode        = "inference";  // inference | stream | direct
+    std::string hostname    = "127.0.0.1";
+    int32_t     port        = 8178;
+
+    std::string model       = "models/ggml-base.en.bin"; // --mode direct only
+    std::string fname_wav;                  // recorded corpus; empty = synthetic
+    float       duration_s  = 10.0f;        // synthetic audio length
+
+    int32_t n_requests      = 16;
+    int32_t concurrency     = 1;
+    int32_t n_threads       = std::min(4, (int32_t) std::thread::hardware_concurrency());
+
+    std::string response_format = "json";
+    bool        use_gpu     = true;
+    bool        flash_attn  = false;
+};
+
+void bench_print_usage(const char * argv0, const bench_params & params) {
+    fprintf(stderr, "\nusage: %s [options]\n\n", argv0);
+    fprintf(stderr, "options:\n");
+    fprintf(stderr, "  -h,  --help                [default] show this help message and exit\n");
+    fprintf(stderr, "       --mode MODE           [%-7s] inference, stream or direct\n", params.mode.c_str());
+    fprintf(stderr, "       --host HOST           [%-7s] server hostname (inference/stream)\n", params.hostname.c_str());
+    fprintf(stderr, "       --port PORT           [%-7d] server port (inference/stream)\n", params.port);
+    fprintf(stderr, "  -m,  --model FNAME         [%-7s] model path (direct)\n", params.model.c_str());
+    fprintf(stderr, "  -f,  --file FNAME          [%-7s] recorded WAV corpus; default is synthetic audio\n", "");
+    fprintf(stderr, "  -d,  --duration T          [%-7.1f] synthetic audio length in seconds\n", params.duration_s);
+    fprintf(stderr, "  -n,  --requests N          [%-7d] total requests to issue\n", params.n_requests);
+    fprintf(stderr, "  -c,  --concurrency N       [%-7d] parallel client threads\n", params.concurrency);
+    fprintf(stderr, "  -t,  --threads N           [%-7d] decode threads (direct)\n", params.n_threads);
+    fprintf(stderr, "       --response-format F   [%-7s] response_format form field (inference)\n", params.response_format.c_str());
+    fprintf(stderr, "  -ng, --no-gpu              [%-7s] disable GPU (direct)\n", params.use_gpu ? "false" : "true");
+    fprintf(stderr, "  -fa, --flash-attn          [%-7s] enable flash attention (direct)\n", params.flash_attn ? "true" : "false");
+    fprintf(stderr, "\n");
+}
+
+bool bench_params_parse(int argc, char ** argv, bench_params & params) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            bench_print_usage(argv[0], params);
+            exit(0);
+        }
+        else if (                  arg == "--mode")            { params.mode            = argv[++i]; }
+        else if (                  arg == "--host")            { params.hostname        = argv[++i]; }
+        else if (                  arg == "--port")            { params.port            = std::stoi(argv[++i]); }
+        else if (arg == "-m"    || arg == "--model")           { params.model           = argv[++i]; }
+        else if (arg == "-f"    || arg == "--file")            { params.fname_wav       = argv[++i]; }
+        else if (arg == "-d"    || arg == "--duration")        { params.duration_s      = std::stof(argv[++i]); }
+        else if (arg == "-n"    || arg == "--requests")        { params.n_requests      = std::stoi(argv[++i]); }
+        else if (arg == "-c"    || arg == "--concurrency")     { params.concurrency     = std::stoi(argv[++i]); }
+        else if (arg == "-t"    || arg == "--threads")         { params.n_threads       = std::stoi(argv[++i]); }
+        else if (                  arg == "--response-format") { params.response_format = argv[++i]; }
+        else if (arg == "-ng"   || arg == "--no-gpu")          { params.use_gpu         = false; }
+        else if (arg == "-fa"   || arg == "--flash-attn")      { params.flash_attn      = true; }
+        else {
+            fprintf(stderr, "error: unknown argument: %s\n", arg.c_str());
+            bench_print_usage(argv[0], params);
+            return false;
+        }
+    }
+
+    if (params.mode != "inference" && params.mode != "stream" && params.mode != "direct") {
+        fprintf(stderr, "error: unknown mode '%s'\n", params.mode.c_str());
+        return false;
+    }
+    if (params.n_requests < 1 || params.concurrency < 1) {
+        fprintf(stderr, "error: --requests and --concurrency must be at least 1\n");
+        return false;
+    }
+
+    return true;
+}
+
+// synthetic corpus: a 440 Hz tone with light noise, enough signal for the
+// encoder to do representative work without shipping audio fixtures
+std::vector<float> make_synthetic_audio(float duration_s) {
+    const size_t n_samples = (size_t) (duration_s * WHISPER_SAMPLE_RATE);
+    std::vector<float> pcmf32(n_samples);
+
+    std::mt19937 rng(4242);
+    std::uniform_real_distribution<float> noise(-0.01f, 0.01f);
+
+    for (size_t i = 0; i < n_samples; i++) {
+        pcmf32[i] = 0.1f * sinf(2.0f * (float) M_PI * 440.0f * i / WHISPER_SAMPLE_RATE) + noise(rng);
+    }
+
+    return pcmf32;
+}
+
+// minimal 16-bit PCM mono WAV container around the float samples, for the
+// HTTP upload paths
+std::string make_wav_blob(const std::vector<float> & pcmf32) {
+    const uint32_t n_bytes = (uint32_t) (pcmf32.size() * sizeof(int16_t));
+
+    std::string wav;
+    wav.reserve(44 + n_bytes);
+
+    auto put_u32 = [&](uint32_t v) { wav.append((const char *) &v, 4); };
+    auto put_u16 = [&](uint16_t v) { wav.append((const char *) &v, 2); };
+
+    wav.append("RIFF", 4); put_u32(36 + n_bytes);
+    wav.append("WAVE", 4);
+    wav.append("fmt ", 4); put_u32(16);
+    put_u16(1);                             // PCM
+    put_u16(1);                             // mono
+    put_u32(WHISPER_SAMPLE_RATE);
+    put_u32(WHISPER_SAMPLE_RATE * sizeof(int16_t));
+    put_u16(sizeof(int16_t));
+    put_u16(16);
+    wav.append("data", 4); put_u32(n_bytes);
+
+    for (const float f : pcmf32) {
+        const float clamped = std::max(-1.0f, std::min(1.0f, f));
+        const int16_t s = (int16_t) (clamped * 32767.0f);
+        wav.append((const char *) &s, 2);
+    }
+
+    return wav;
+}
+
+double peak_rss_mb() {
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+        return usage.ru_maxrss / 1024.0;
+#endif
+    }
+#endif
+    return 0.0;
+}
+
+double percentile(std::vector<double> sorted_ms, double p) {
+    if (sorted_ms.empty()) {
+        return 0.0;
+    }
+    const size_t idx = (size_t) (p * (sorted_ms.size() - 1) + 0.5);
+    return sorted_ms[std::min(idx, sorted_ms.size() - 1)];
+}
+
+struct bench_results {
+    std::mutex mutex;
+    std::vector<double> latencies_ms;
+    int n_failed = 0;
+
+    void record(double ms, bool ok) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (ok) {
+            latencies_ms.push_back(ms);
+        } else {
+            n_failed++;
+        }
+    }
+};
+
+void run_http_bench(const bench_params & params, const std::string & wav_blob, bench_results & results) {
+    const std::string path = params.mode == "stream" ? "/stream" : "/inference";
+
+    std::vector<std::thread> workers;
+    std::atomic<int> next_request{0};
+
+    for (int w = 0; w < params.concurrency; w++) {
+        workers.emplace_back([&]() {
+            httplib::Client cli(params.hostname, params.port);
+            cli.set_read_timeout(600, 0);
+
+            for (;;) {
+                const int req_idx = next_request.fetch_add(1);
+                if (req_idx >= params.n_requests) {
+                    break;
+                }
+
+                // one session per request: a shared id would funnel every
+                // worker into the same session mutex and re-decode its
+                // accumulated buffer, measuring lock contention and buffer
+                // growth instead of server concurrency
+                const std::string session_id = "bench-" + std::to_string(req_idx);
+
+                httplib::MultipartFormDataItems items;
+                if (params.mode == "stream") {
+                    // /stream takes raw f32 samples; reuse the blob's payload
+                    items.push_back({"session_id", session_id, "", ""});
+                    items.push_back({"audio", wav_blob, "audio.raw", "application/octet-stream"});
+                } else {
+                    items.push_back({"file", wav_blob, "bench.wav", "audio/wav"});
+                    items.push_back({"response_format", params.response_format, "", ""});
+                }
+
+                const auto t_start = std::chrono::steady_clock::now();
+                auto res = cli.Post(path, items);
+                const auto t_end = std::chrono::steady_clock::now();
+
+                const double ms = std::chrono::duration<double, std::milli>(t_end - t_start).count();
+                results.record(ms, res && res->status == 200);
+
+                if (params.mode == "stream") {
+                    // untimed teardown so the server does not keep one decode
+                    // state per benchmark request until idle eviction
+                    httplib::MultipartFormDataItems teardown;
+                    teardown.push_back({"session_id", session_id, "", ""});
+                    teardown.push_back({"audio", "", "", ""});
+                    teardown.push_back({"final", "true", "", ""});
+                    cli.Post(path, teardown);
+                }
+            }
+        });
+    }
+
+    for (auto & worker : workers) {
+        worker.join();
+    }
+}
+
+int run_direct_bench(const bench_params & params, const std::vector<float> & pcmf32, bench_results & results) {
+    struct whisper_context_params cparams = whisper_context_default_params();
+    cparams.use_gpu    = params.use_gpu;
+    cparams.flash_attn = params.flash_attn;
+
+    struct whisper_context * ctx = whisper_init_from_file_with_params(params.model.c_str(), cparams);
+    if (ctx == nullptr) {
+        fprintf(stderr, "[ERROR] Failed to initialize whisper context from '%s'\n", params.model.c_str());
+        fflush(stderr);
+        return 1;
+    }
+
+    // one state per client thread, same layout as the server's worker pool
+    std::vector<std::thread> workers;
+    std::atomic<int> next_request{0};
+
+    for (int w = 0; w < params.concurrency; w++) {
+        workers.emplace_back([&]() {
+            struct whisper_state * state = whisper_init_state(ctx);
+            if (state == nullptr) {
+                fprintf(stderr, "[ERROR] Failed to initialize whisper state\n");
+                fflush(stderr);
+                return;
+            }
+
+            while (next_request.fetch_add(1) < params.n_requests) {
+                whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+                wparams.n_threads        = params.n_threads;
+                wparams.print_progress   = false;
+                wparams.print_realtime   = false;
+                wparams.print_timestamps = false;
+
+                const auto t_start = std::chrono::steady_clock::now();
+                const int ret = whisper_full_with_state(ctx, state, wparams, pcmf32.data(), pcmf32.size());
+                const auto t_end = std::chrono::steady_clock::now();
+
+                const double ms = std::chrono::duration<double, std::milli>(t_end - t_start).count();
+                results.record(ms, ret == 0);
+            }
+
+            whisper_free_state(state);
+        });
+    }
+
+    for (auto & worker : workers) {
+        worker.join();
+    }
+
+    whisper_free(ctx);
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char ** argv) {
+    bench_params params;
+
+    if (!bench_params_parse(argc, argv, params)) {
+        return 1;
+    }
+
+    // corpus: recorded WAV or synthetic tone
+    std::vector<float> pcmf32;
+    std::vector<std::vector<float>> pcmf32s;
+    if (!params.fname_wav.empty()) {
+        if (!::read_wav(params.fname_wav, pcmf32, pcmf32s, false)) {
+            fprintf(stderr, "[ERROR] Failed to read WAV file '%s'\n", params.fname_wav.c_str());
+            fflush(stderr);
+            return 1;
+        }
+    } else {
+        pcmf32 = make_synthetic_audio(params.duration_s);
+    }
+
+    const double audio_s = (double) pcmf32.size() / WHISPER_SAMPLE_RATE;
+
+    fprintf(stderr, "[CONFIG] Mode: %s, Requests: %d, Concurrency: %d\n",
+            params.mode.c_str(), params.n_requests, params.concurrency);
+    fprintf(stderr, "[CONFIG] Audio: %.1f sec per request (%s)\n",
+            audio_s, params.fname_wav.empty() ? "synthetic" : params.fname_wav.c_str());
+    fflush(stderr);
+
+    bench_results results;
+    const auto t_start = std::chrono::steady_clock::now();
+
+    if (params.mode == "direct") {
+        if (run_direct_bench(params, pcmf32, results) != 0) {
+            return 1;
+        }
+    } else {
+        std::string blob;
+        if (params.mode == "stream") {
+            // /stream consumes raw little-endian f32 samples
+            blob.assign((const char *) pcmf32.data(), pcmf32.size() * sizeof(float));
+        } else {
+            blob = make_wav_blob(pcmf32);
+        }
+        run_http_bench(params, blob, results);
+    }
+
+    const auto t_end = std::chrono::steady_clock::now();
+    const double wall_s = std::chrono::duration<double>(t_end - t_start).count();
+
+    auto & lat = results.latencies_ms;
+    std::sort(lat.begin(), lat.end());
+
+    double total_ms = 0.0;
+    for (const double ms : lat) {
+        total_ms += ms;
+    }
+    const double mean_ms = lat.empty() ? 0.0 : total_ms / lat.size();
+
+    // aggregate RTF: processing wall time per second of audio (lower is faster)
+    const double audio_total_s = audio_s * lat.size();
+    const double rtf = audio_total_s > 0.0 ? (total_ms / 1000.0) / audio_total_s : 0.0;
+
+    printf("\n");
+    printf("requests:    %zu ok, %d failed\n", lat.size(), results.n_failed);
+    printf("wall time:   %.2f s (%.2f req/s)\n", wall_s, wall_s > 0.0 ? lat.size() / wall_s : 0.0);
+    printf("latency:     mean %.1f ms, p50 %.1f ms, p95 %.1f ms, p99 %.1f ms\n",
+           mean_ms, percentile(lat, 0.50), percentile(lat, 0.95), percentile(lat, 0.99));
+    printf("rtf:         %.3f\n", rtf);
+    printf("peak rss:    %.1f MB%s\n", peak_rss_mb(),
+           params.mode == "direct" ? "" : " (client process only)");
+
+    return results.n_failed > 0 ? 2 : 0;
+}
@@ -4,15 +4,32 @@
 #include "httplib.h"
 #include "json.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
+#include <future>
 #include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <thread>
 #include <vector>
 #include <cstring>
 #include <sstream>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #if defined(_MSC_VER)
 #pragma warning(disable: 4244 4267) // possible loss of data
 #endif
@@ -28,6 +45,8 @@ const std::string text_format   = "text";
 const std::string srt_format    = "srt";
 const std::string vjson_format  = "verbose_json";
 const std::string vtt_format    = "vtt";
+const std::string stream_json_format = "stream_json";
+const std::string bin_format    = "binary";
 
 struct server_params
 {
@@ -40,12 +59,22 @@ struct server_params
     int32_t read_timeout  = 600;
     int32_t write_timeout = 600;
 
+    int32_t n_workers     = 1;
+    int32_t queue_depth   = 64; // max requests waiting for a worker before 429
+    int32_t n_models      = 2;  // max models kept loaded in the LRU cache
+    std::string gpu_devices = ""; // device map, e.g. "0,0,1,1" = 2 workers per GPU
+    int32_t cache_entries = 16; // transcription response cache size; 0 disables
+    std::string cache_dir = ""; // optional on-disk copy of cached responses
+
+    int32_t spill_threshold_mb = 64; // uploads beyond this stream to disk; 0 keeps everything in memory
+
+    int32_t stream_idle_timeout = 300; // seconds before an inactive /stream session is evicted
+
     bool ffmpeg_converter = false;
 };
 
 struct whisper_params {
     int32_t n_threads     = std::min(4, (int32_t) std::thread::hardware_concurrency());
-    int32_t n_processors  = 1;
     int32_t offset_t_ms   = 0;
     int32_t offset_n      = 0;
     int32_t duration_ms   = 0;
@@ -63,6 +92,11 @@ struct whisper_params {
     float temperature_inc =  0.20f;
     float no_speech_thold = 0.6f;
 
+    float vad_thold       = 0.6f;
+
+    bool vad             = false;
+    bool pipeline        = false;
+    bool timing          = false;
     bool debug_mode      = false;
     bool translate       = false;
     bool detect_language = false;
@@ -101,7 +135,6 @@ void whisper_print_usage(int /*argc*/, char ** argv, const whisper_params & para
     fprintf(stderr, "options:\n");
     fprintf(stderr, "  -h,        --help              [default] show this help message and exit\n");
     fprintf(stderr, "  -t N,      --threads N         [%-7d] number of threads to use during computation\n",    params.n_threads);
-    fprintf(stderr, "  -p N,      --processors N      [%-7d] number of processors to use during computation\n", params.n_processors);
     fprintf(stderr, "  -ot N,     --offset-t N        [%-7d] time offset in milliseconds\n",                    params.offset_t_ms);
     fprintf(stderr, "  -on N,     --offset-n N        [%-7d] segment index offset\n",                           params.offset_n);
     fprintf(stderr, "  -d  N,     --duration N        [%-7d] duration of audio to process in milliseconds\n",   params.duration_ms);
@@ -137,9 +170,19 @@ void whisper_print_usage(int /*argc*/, char ** argv, const whisper_params & para
     fprintf(stderr, "  --public PATH,                 [%-7s] Path to the public folder\n", sparams.public_path.c_str());
     fprintf(stderr, "  --request-path PATH,           [%-7s] Request path for all requests\n", sparams.request_path.c_str());
     fprintf(stderr, "  --inference-path PATH,         [%-7s] Inference path for all requests\n", sparams.inference_path.c_str());
+    fprintf(stderr, "  --workers N,                   [%-7d] Number of whisper states processing requests concurrently\n", sparams.n_workers);
+    fprintf(stderr, "  --queue-depth N,               [%-7d] Max requests waiting for a worker before rejecting with 429\n", sparams.queue_depth);
+    fprintf(stderr, "  --models N,                    [%-7d] Max models kept loaded in the LRU cache\n", sparams.n_models);
+    fprintf(stderr, "  --gpu-devices LIST,            [%-7s] Worker-to-GPU map, one entry per worker (e.g. 0,0,1,1)\n", sparams.gpu_devices.c_str());
+    fprintf(stderr, "  --cache N,                     [%-7d] Cached transcription responses kept in memory (0 disables)\n", sparams.cache_entries);
+    fprintf(stderr, "  --cache-dir PATH,              [%-7s] Mirror cached responses to this directory\n", sparams.cache_dir.c_str());
+    fprintf(stderr, "  --spill-threshold N,           [%-7d] Spill uploads larger than N MB to disk (0 = never)\n", sparams.spill_threshold_mb);
     fprintf(stderr, "  --convert,                     [%-7s] Convert audio to WAV, requires ffmpeg on the server\n", sparams.ffmpeg_converter ? "true" : "false");
     fprintf(stderr, "  -sns,      --suppress-nst      [%-7s] suppress non-speech tokens\n", params.suppress_nst ? "true" : "false");
     fprintf(stderr, "  -nth N,    --no-speech-thold N [%-7.2f] no speech threshold\n",   params.no_speech_thold);
+    fprintf(stderr, "  -vad,      --vad               [%-7s] drop non-speech regions before inference\n", params.vad ? "true" : "false");
+    fprintf(stderr, "  -vth N,    --vad-thold N       [%-7.2f] VAD energy threshold (relative to mean RMS)\n", params.vad_thold);
+    fprintf(stderr, "  -pl,       --pipeline          [%-7s] overlap windowed decode with inference for long WAVs\n", params.pipeline ? "true" : "false");
     fprintf(stderr, "\n");
 }
 
@@ -152,7 +195,13 @@ bool whisper_params_parse(int argc, char ** argv, whisper_params & params, serve
             exit(0);
         }
         else if (arg == "-t"    || arg == "--threads")         { params.n_threads       = std::stoi(argv[++i]); }
-        else if (arg == "-p"    || arg == "--processors")      { params.n_processors    = std::stoi(argv[++i]); }
+        // accepted for old launch scripts, but whisper_full_parallel is gone:
+        // concurrency comes from the --workers state pool now
+        else if (arg == "-p"    || arg == "--processors")      {
+            fprintf(stderr, "[WARNING] -p/--processors is ignored, superseded by --workers\n");
+            fflush(stderr);
+            ++i;
+        }
         else if (arg == "-ot"   || arg == "--offset-t")        { params.offset_t_ms     = std::stoi(argv[++i]); }
         else if (arg == "-on"   || arg == "--offset-n")        { params.offset_n        = std::stoi(argv[++i]); }
         else if (arg == "-d"    || arg == "--duration")        { params.duration_ms     = std::stoi(argv[++i]); }
@@ -186,6 +235,9 @@ bool whisper_params_parse(int argc, char ** argv, whisper_params & params, serve
         else if (arg == "-fa"   || arg == "--flash-attn")      { params.flash_attn      = true; }
         else if (arg == "-sns"  || arg == "--suppress-nst")    { params.suppress_nst    = true; }
         else if (arg == "-nth"  || arg == "--no-speech-thold") { params.no_speech_thold = std::stof(argv[++i]); }
+        else if (arg == "-vad"  || arg == "--vad")             { params.vad             = true; }
+        else if (arg == "-vth"  || arg == "--vad-thold")       { params.vad_thold       = std::stof(argv[++i]); }
+        else if (arg == "-pl"   || arg == "--pipeline")        { params.pipeline        = true; }
 
         // server params
         else if (                  arg == "--port")            { sparams.port        = std::stoi(argv[++i]); }
@@ -193,6 +245,13 @@ bool whisper_params_parse(int argc, char ** argv, whisper_params & params, serve
         else if (                  arg == "--public")          { sparams.public_path = argv[++i]; }
         else if (                  arg == "--request-path")    { sparams.request_path = argv[++i]; }
         else if (                  arg == "--inference-path")  { sparams.inference_path = argv[++i]; }
+        else if (                  arg == "--workers")         { sparams.n_workers   = std::stoi(argv[++i]); }
+        else if (                  arg == "--queue-depth")     { sparams.queue_depth = std::stoi(argv[++i]); }
+        else if (                  arg == "--models")          { sparams.n_models    = std::stoi(argv[++i]); }
+        else if (                  arg == "--gpu-devices")     { sparams.gpu_devices = argv[++i]; }
+        else if (                  arg == "--cache")           { sparams.cache_entries = std::stoi(argv[++i]); }
+        else if (                  arg == "--cache-dir")       { sparams.cache_dir   = argv[++i]; }
+        else if (                  arg == "--spill-threshold") { sparams.spill_threshold_mb = std::stoi(argv[++i]); }
         else if (                  arg == "--convert")         { sparams.ffmpeg_converter     = true; }
         else {
             fprintf(stderr, "error: unknown argument: %s\n", arg.c_str());
@@ -207,10 +266,757 @@ bool whisper_params_parse(int argc, char ** argv, whisper_params & params, serve
 struct whisper_print_user_data {
     const whisper_params * params;
 
-    const std::vector<std::vector<float>> * pcmf32s;
+    const struct diarization_energy_index * energy;
     int progress_prev;
 };
 
+// Pool of whisper states sharing a single model context. Each state carries
+// its own KV cache and decode buffers, so N states can run whisper_full_with_state
+// concurrently over the same (read-only) model weights. Requests that arrive
+// while all states are busy block in acquire() until one is released.
+struct whisper_state_pool {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<struct whisper_state *> idle;
+    size_t n_states = 0;
+
+    bool init(struct whisper_context * ctx, int n_workers) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int i = 0; i < n_workers; i++) {
+            struct whisper_state * state = whisper_init_state(ctx);
+            if (state == nullptr) {
+                fprintf(stderr, "[ERROR] Failed to initialize whisper state %d/%d\n", i + 1, n_workers);
+                fflush(stderr);
+                // free the states created so far: leaving them in idle with
+                // n_states still 0 would make drain() wait forever when the
+                // owning entry is destroyed
+                for (auto * s : idle) {
+                    whisper_free_state(s);
+                }
+                idle.clear();
+                return false;
+            }
+            idle.push_back(state);
+        }
+        n_states = idle.size();
+        return true;
+    }
+
+    struct whisper_state * acquire() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return !idle.empty(); });
+        struct whisper_state * state = idle.back();
+        idle.pop_back();
+        return state;
+    }
+
+    // states currently checked out - the load signal for device dispatch
+    size_t n_busy() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return n_states - idle.size();
+    }
+
+    void release(struct whisper_state * state) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            idle.push_back(state);
+        }
+        cv.notify_one();
+    }
+
+    // Wait for all in-flight requests to return their states, then free them.
+    // Used by /load before the model context is replaced.
+    void drain() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return idle.size() == n_states; });
+        for (auto * state : idle) {
+            whisper_free_state(state);
+        }
+        idle.clear();
+        n_states = 0;
+    }
+};
+
+// RAII guard so states go back to the pool on every handler exit path
+struct whisper_state_guard {
+    whisper_state_pool & pool;
+    struct whisper_state * state;
+
+    whisper_state_guard(whisper_state_pool & pool) : pool(pool), state(pool.acquire()) {}
+    ~whisper_state_guard() { pool.release(state); }
+};
+
+// A loaded model plus its worker states. Handlers hold these via shared_ptr,
+// so an entry evicted from the cache (or displaced by /load) stays alive
+// until the last in-flight request using it finishes.
+struct model_entry {
+    std::string path;
+    struct whisper_context * ctx = nullptr;
+    whisper_state_pool pool;
+    uint64_t last_used = 0;
+    int32_t gpu_device = -1;         // pinned device, -1 = loader default
+    std::atomic<bool> warmed{false}; // set after the synthetic warm-up pass
+
+    ~model_entry() {
+        if (ctx) {
+            pool.drain();
+            whisper_free(ctx);
+        }
+    }
+};
+
+// LRU cache of loaded models, keyed by model file path. Requests can select
+// a model per request; a miss loads the model while other models keep
+// serving traffic, and the least-recently-used entry beyond capacity is
+// dropped (actual freeing deferred until its in-flight users are done).
+struct model_cache {
+    std::mutex mutex;
+    std::map<std::string, std::shared_ptr<model_entry>> entries;
+
+    size_t capacity = 2;
+    uint64_t counter = 0;
+
+    // load-time configuration, fixed at startup
+    struct whisper_context_params cparams;
+    std::string openvino_device;
+    int32_t n_workers = 1;
+
+    // device map from --gpu-devices: one (device, workers) pair per distinct
+    // GPU, in first-appearance order. Empty = one shard on the default device.
+    std::vector<std::pair<int32_t, int32_t>> device_workers;
+
+    // cache key for one shard of a model; single-device setups use the path
+    static std::string shard_key(const std::string & path, int32_t device) {
+        return device < 0 ? path : path + "@gpu" + std::to_string(device);
+    }
+
+    std::shared_ptr<model_entry> get(const std::string & path, std::string & error) {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        if (device_workers.empty()) {
+            return get_shard(path, -1, n_workers, error, lock);
+        }
+
+        // one shard per device: make sure all exist, then route the request
+        // to the device with the fewest states checked out right now
+        std::shared_ptr<model_entry> best;
+        size_t best_busy = 0;
+        for (const auto & dw : device_workers) {
+            auto entry = get_shard(path, dw.first, dw.second, error, lock);
+            if (entry == nullptr) {
+                return nullptr;
+            }
+            const size_t busy = entry->pool.n_busy();
+            if (best == nullptr || busy < best_busy) {
+                best = entry;
+                best_busy = busy;
+            }
+        }
+        return best;
+    }
+
+    // lookup without loading on a miss, for readiness reporting; with a
+    // device map the first shard stands in for the model
+    std::shared_ptr<model_entry> peek(const std::string & path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const int32_t device = device_workers.empty() ? -1 : device_workers.front().first;
+        auto it = entries.find(shard_key(path, device));
+        return it != entries.end() ? it->second : nullptr;
+    }
+
+    // every loaded shard of a model, for warm-up passes across devices
+    std::vector<std::shared_ptr<model_entry>> shards_of(const std::string & path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<std::shared_ptr<model_entry>> shards;
+        if (device_workers.empty()) {
+            auto it = entries.find(path);
+            if (it != entries.end()) {
+                shards.push_back(it->second);
+            }
+            return shards;
+        }
+        for (const auto & dw : device_workers) {
+            auto it = entries.find(shard_key(path, dw.first));
+            if (it != entries.end()) {
+                shards.push_back(it->second);
+            }
+        }
+        return shards;
+    }
+
+private:
+    // shards currently being loaded; a second request for the same shard
+    // waits on the loader's future instead of starting a duplicate load
+    std::map<std::string, std::shared_future<std::shared_ptr<model_entry>>> loading;
+
+    // Find-or-load one shard. The caller's lock is released for the load
+    // itself (and while waiting on another thread's load), so requests on
+    // already-cached entries never queue behind a multi-second model load;
+    // only the map bookkeeping is serialized.
+    std::shared_ptr<model_entry> get_shard(const std::string & path, int32_t device,
+                                           int32_t n_shard_workers, std::string & error,
+                                           std::unique_lock<std::mutex> & lock) {
+        const std::string key = shard_key(path, device);
+
+        auto it = entries.find(key);
+        if (it != entries.end()) {
+            it->second->last_used = ++counter;
+            return it->second;
+        }
+
+        auto pending = loading.find(key);
+        if (pending != loading.end()) {
+            auto future = pending->second;
+            lock.unlock();
+            auto entry = future.get();
+            lock.lock();
+            if (entry == nullptr) {
+                error = "failed to initialize whisper context for " + path;
+                return nullptr;
+            }
+            entry->last_used = ++counter;
+            return entry;
+        }
+
+        if (!is_file_exist(path.c_str())) {
+            error = "model file not found: " + path;
+            return nullptr;
+        }
+
+        // this thread is the loader: publish the future, then drop the lock
+        // for the load (cparams et al. are fixed at startup, safe unlocked)
+        std::promise<std::shared_ptr<model_entry>> promise;
+        loading[key] = promise.get_future().share();
+        lock.unlock();
+
+        if (device >= 0) {
+            fprintf(stderr, "[INFO] Loading model '%s' into cache (GPU %d, %d worker(s))\n",
+                    path.c_str(), device, n_shard_workers);
+        } else {
+            fprintf(stderr, "[INFO] Loading model '%s' into cache\n", path.c_str());
+        }
+        fflush(stderr);
+
+        struct whisper_context_params shard_cparams = cparams;
+        if (device >= 0) {
+            shard_cparams.use_gpu    = true;
+            shard_cparams.gpu_device = device;
+        }
+
+        auto entry = std::make_shared<model_entry>();
+        entry->path = path;
+        entry->gpu_device = device;
+        entry->ctx = whisper_init_from_file_with_params(path.c_str(), shard_cparams);
+        if (entry->ctx == nullptr) {
+            error = "failed to initialize whisper context for " + path;
+            entry = nullptr;
+        } else {
+            // no effect on builds without OpenVINO configured
+            whisper_ctx_init_openvino_encoder(entry->ctx, nullptr, openvino_device.c_str(), nullptr);
+
+            if (!entry->pool.init(entry->ctx, n_shard_workers)) {
+                error = "failed to initialize worker states for " + path;
+                entry = nullptr; // entry destructor frees the context
+            }
+        }
+
+        lock.lock();
+        loading.erase(key);
+        promise.set_value(entry);
+        if (entry == nullptr) {
+            return nullptr;
+        }
+
+        entry->last_used = ++counter;
+        entries[key] = entry;
+
+        // capacity counts models, so with a device map each model may keep
+        // one shard per device
+        const size_t max_entries = capacity * (device_workers.empty() ? 1 : device_workers.size());
+        while (entries.size() > max_entries) {
+            auto lru = entries.begin();
+            for (auto e = entries.begin(); e != entries.end(); ++e) {
+                if (e->second->last_used < lru->second->last_used) {
+                    lru = e;
+                }
+            }
+            fprintf(stderr, "[INFO] Evicting model '%s' from cache\n", lru->first.c_str());
+            fflush(stderr);
+            entries.erase(lru);
+        }
+
+        return entry;
+    }
+};
+
+// Run ~1s of silence through a freshly loaded model so GPU kernel
+// compilation / Metal shader warm-up is paid here and not by the first
+// live caption of the day
+bool warm_up_model(const std::shared_ptr<model_entry> & model, int n_threads) {
+    std::vector<float> silence(WHISPER_SAMPLE_RATE, 0.0f);
+
+    whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    wparams.n_threads        = n_threads;
+    wparams.print_progress   = false;
+    wparams.print_realtime   = false;
+    wparams.print_timestamps = false;
+    wparams.no_context       = true;
+    wparams.single_segment   = true;
+
+    const auto t_start = std::chrono::steady_clock::now();
+
+    whisper_state_guard guard(model->pool);
+    const bool ok = whisper_full_with_state(model->ctx, guard.state, wparams,
+                                            silence.data(), silence.size()) == 0;
+    model->warmed = ok;
+
+    const auto t_end = std::chrono::steady_clock::now();
+    fprintf(stderr, "[INFO] Warm-up inference for '%s' %s in %.0f ms\n",
+            model->path.c_str(), ok ? "completed" : "failed",
+            std::chrono::duration<double, std::milli>(t_end - t_start).count());
+    fflush(stderr);
+
+    return ok;
+}
+
+// Operational counters for the /metrics endpoint. Everything is a plain
+// atomic bumped from the hot path, so instrumentation adds no locks; the
+// Prometheus text is rendered only when /metrics is scraped.
+struct server_metrics {
+    std::atomic<uint64_t> inference_requests{0};
+    std::atomic<uint64_t> inference_failures{0};
+    std::atomic<uint64_t> stream_requests{0};
+    std::atomic<uint64_t> stream_failures{0};
+
+    std::atomic<uint64_t> audio_ms{0};       // audio transcribed (both endpoints)
+    std::atomic<uint64_t> decode_stage_ms{0};    // in-memory WAV parse / ffmpeg fallback
+    std::atomic<uint64_t> inference_stage_ms{0}; // whisper_full wall time
+    std::atomic<uint64_t> serialize_stage_ms{0}; // response formatting
+
+    uint64_t now_ms() const {
+        return (uint64_t) std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+// elapsed-ms helper for the stage counters above; stops at scope exit or on
+// an explicit stop() so stages that end mid-handler are not over-counted
+struct stage_timer {
+    std::atomic<uint64_t> * counter;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint64_t elapsed_ms = 0; // fixed at stop(), for per-request reporting
+
+    stage_timer(std::atomic<uint64_t> & counter) : counter(&counter) {}
+
+    void stop() {
+        if (counter) {
+            elapsed_ms = (uint64_t) std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            *counter += elapsed_ms;
+            counter = nullptr;
+        }
+    }
+
+    ~stage_timer() { stop(); }
+};
+
+// Admission control in front of the inference workers. httplib already runs
+// each request on its own thread, so the queue is a bounded set of waiting
+// slots: at most max_active decodes run at once, live /stream chunks are
+// admitted ahead of batch /inference uploads, and once max_depth requests
+// are waiting new arrivals are rejected immediately instead of piling up
+// until the read/write timeouts expire.
+struct admission_queue {
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    int32_t max_active = 1;
+    int32_t max_depth  = 64;
+
+    int32_t active       = 0;
+    int32_t waiting_high = 0;
+    int32_t waiting_low  = 0;
+
+    std::atomic<uint64_t> n_rejected{0};
+
+    // Returns false (without blocking) when the queue is full.
+    bool enter(bool high_priority) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (waiting_high + waiting_low >= max_depth) {
+            n_rejected++;
+            return false;
+        }
+
+        int32_t & waiting = high_priority ? waiting_high : waiting_low;
+        waiting++;
+        cv.wait(lock, [&] {
+            if (active >= max_active) {
+                return false;
+            }
+            // batch requests yield to queued live chunks
+            if (!high_priority && waiting_high > 0) {
+                return false;
+            }
+            return true;
+        });
+        waiting--;
+        active++;
+        return true;
+    }
+
+    void leave() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            active--;
+        }
+        cv.notify_all();
+    }
+
+    int32_t depth() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return waiting_high + waiting_low;
+    }
+
+    int32_t active_now() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return active;
+    }
+};
+
+// RAII ticket; check admitted before doing any work
+struct admission_ticket {
+    admission_queue & queue;
+    bool admitted;
+
+    admission_ticket(admission_queue & queue, bool high_priority)
+        : queue(queue), admitted(queue.enter(high_priority)) {}
+    ~admission_ticket() {
+        if (admitted) {
+            queue.leave();
+        }
+    }
+};
+
+// 429 + Retry-After so overloaded clients back off instead of retrying hot
+void send_queue_full(Response & res, admission_queue & queue) {
+    res.status = 429;
+    res.set_header("Retry-After", "30");
+    json body = json{
+        {"error", "server overloaded, inference queue is full"},
+        {"queue_depth", queue.depth()},
+    };
+    res.set_content(body.dump(), "application/json");
+}
+
+// In-flight inference requests, keyed by a client-supplied "request_id" form
+// field. Each request gets its own atomic abort token wired into whisper's
+// encoder_begin/abort callbacks; DELETE /inference/<id> flips the token and
+// the worker frees itself within one encoder iteration instead of burning
+// minutes on a transcription nobody will read.
+struct inflight_registry {
+    std::mutex mutex;
+    std::map<std::string, std::shared_ptr<std::atomic<bool>>> tokens;
+
+    std::shared_ptr<std::atomic<bool>> add(const std::string & id) {
+        auto token = std::make_shared<std::atomic<bool>>(false);
+        if (!id.empty()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            tokens[id] = token;
+        }
+        return token;
+    }
+
+    void remove(const std::string & id) {
+        if (id.empty()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        tokens.erase(id);
+    }
+
+    bool cancel(const std::string & id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = tokens.find(id);
+        if (it == tokens.end()) {
+            return false;
+        }
+        it->second->store(true);
+        return true;
+    }
+};
+
+// unregisters the request id on every handler exit path
+struct inflight_guard {
+    inflight_registry & registry;
+    std::string id;
+
+    inflight_guard(inflight_registry & registry, std::string id)
+        : registry(registry), id(std::move(id)) {}
+    ~inflight_guard() { registry.remove(id); }
+};
+
+// One live /stream client. Each session owns its PCM buffer, overlap window
+// and whisper state, keyed by a client-supplied session ID, so two concurrent
+// meetings never interleave audio or serialize on a shared decode context.
+struct stream_session {
+    std::mutex mutex; // serializes chunks arriving for the same session
+    std::vector<float> audio_buffer;
+    std::shared_ptr<model_entry> model; // pinned for the session's lifetime
+    struct whisper_state * state = nullptr;
+    std::chrono::steady_clock::time_point last_active = std::chrono::steady_clock::now();
+
+    // incremental mode: decoder text context is carried across chunks and the
+    // audio window is trimmed past confirmed segments, so per-chunk cost stays
+    // flat instead of growing with meeting length
+    bool incremental = false;
+    std::vector<whisper_token> prompt_tokens; // confirmed tokens fed back as the decoder prompt
+    std::vector<std::string> prev_texts;      // previous decode's tentative texts, for local agreement
+    int64_t t_offset = 0;                     // timestamp offset (10ms units) of the trimmed buffer start
+
+    // SSE push transport: segment events queued here are drained by a
+    // persistent GET /stream/events connection, so clients get captions as
+    // they are produced instead of polling full JSON responses
+    std::mutex events_mutex;
+    std::condition_variable events_cv;
+    std::deque<std::string> events;
+    int subscribers = 0; // live GET /stream/events connections
+    bool closed = false;
+
+    void push_event(const std::string & data) {
+        {
+            std::lock_guard<std::mutex> lock(events_mutex);
+            // poll-style clients never open /stream/events; without this
+            // check the queue would grow for the life of the meeting
+            if (subscribers == 0) {
+                return;
+            }
+            events.push_back(data);
+        }
+        events_cv.notify_all();
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(events_mutex);
+            closed = true;
+        }
+        events_cv.notify_all();
+    }
+
+    ~stream_session() {
+        if (state) {
+            whisper_free_state(state);
+        }
+    }
+};
+
+struct stream_session_store {
+    std::mutex mutex;
+    std::map<std::string, std::shared_ptr<stream_session>> sessions;
+
+    std::shared_ptr<stream_session> get_or_create(const std::string & id, const std::shared_ptr<model_entry> & model) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = sessions.find(id);
+        if (it != sessions.end()) {
+            it->second->last_active = std::chrono::steady_clock::now();
+            return it->second;
+        }
+        auto session = std::make_shared<stream_session>();
+        session->model = model;
+        session->state = whisper_init_state(model->ctx);
+        if (session->state == nullptr) {
+            return nullptr;
+        }
+        sessions[id] = session;
+        return session;
+    }
+
+    void remove(const std::string & id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = sessions.find(id);
+        if (it != sessions.end()) {
+            it->second->close();
+            sessions.erase(it);
+        }
+    }
+
+    // Drop sessions that have not received audio for idle_timeout seconds.
+    // Called on each /stream request - cheap enough that no sweeper thread is needed.
+    void evict_idle(int32_t idle_timeout_s) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto now = std::chrono::steady_clock::now();
+        for (auto it = sessions.begin(); it != sessions.end(); ) {
+            const auto idle_s = std::chrono::duration_cast<std::chrono::seconds>(now - it->second->last_active).count();
+            if (idle_s > idle_timeout_s) {
+                fprintf(stderr, "[INFO] Evicting idle stream session '%s' (%llds inactive)\n",
+                        it->first.c_str(), (long long) idle_s);
+                fflush(stderr);
+                it->second->close();
+                it = sessions.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return sessions.size();
+    }
+};
+
+// Decode whatever audio has accumulated in a stream session and build the
+// /stream JSON response. The caller must hold session.mutex and have already
+// appended the chunk's samples - both the multipart /stream route and the raw
+// PCM ingest route funnel through here.
+json run_stream_decode(stream_session & session, const whisper_params & params, const std::string & session_id) {
+    struct whisper_context * ctx = session.model->ctx;
+
+    const int MIN_AUDIO_LENGTH_MS = 1000;  // minimum 1 second of audio
+    const size_t min_samples = (MIN_AUDIO_LENGTH_MS * WHISPER_SAMPLE_RATE) / 1000;
+
+    auto & audio_buffer = session.audio_buffer;
+
+    json response;
+    response["segments"] = json::array();
+
+    if (session.incremental) {
+        // Incremental mode: re-decode only the unconfirmed window, carrying
+        // confirmed tokens as the decoder prompt. Segments are confirmed by
+        // local agreement - two consecutive decodes producing identical text -
+        // and the audio behind them is trimmed, so chunk latency does not
+        // grow with the length of the meeting.
+        if (audio_buffer.size() >= min_samples) {
+            whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+            wparams.print_progress = false;
+            wparams.print_special  = params.print_special;
+            wparams.language       = params.language.c_str();
+            wparams.n_threads      = params.n_threads;
+            wparams.n_max_text_ctx = params.max_context >= 0 ? params.max_context : wparams.n_max_text_ctx;
+
+            if (!session.prompt_tokens.empty()) {
+                wparams.prompt_tokens   = session.prompt_tokens.data();
+                wparams.prompt_n_tokens = (int) session.prompt_tokens.size();
+            }
+
+            if (whisper_full_with_state(ctx, session.state, wparams, audio_buffer.data(), audio_buffer.size()) != 0) {
+                return json{{"error", "failed to process audio"}};
+            }
+
+            const int n_segments = whisper_full_n_segments_from_state(session.state);
+
+            // local agreement: confirm the longest prefix of segments whose text
+            // matches the previous decode; the trailing segment stays tentative
+            // because more audio may still change it
+            int n_confirmed = 0;
+            for (int i = 0; i + 1 < n_segments; ++i) {
+                const char * text = whisper_full_get_segment_text_from_state(session.state, i);
+                if ((size_t) i < session.prev_texts.size() && session.prev_texts[i] == text) {
+                    n_confirmed++;
+                } else {
+                    break;
+                }
+            }
+
+            for (int i = 0; i < n_segments; ++i) {
+                json segment;
+                segment["text"]  = whisper_full_get_segment_text_from_state(session.state, i);
+                segment["t0"]    = whisper_full_get_segment_t0_from_state(session.state, i) + session.t_offset;
+                segment["t1"]    = whisper_full_get_segment_t1_from_state(session.state, i) + session.t_offset;
+                segment["final"] = i < n_confirmed;
+                session.push_event(segment.dump());
+                response["segments"].push_back(segment);
+            }
+
+            // remember this decode's unconfirmed texts for the next agreement pass
+            session.prev_texts.clear();
+            for (int i = n_confirmed; i < n_segments; ++i) {
+                session.prev_texts.push_back(whisper_full_get_segment_text_from_state(session.state, i));
+            }
+
+            if (n_confirmed > 0) {
+                // carry the confirmed tokens forward as decoder context,
+                // capped to the text context window
+                for (int i = 0; i < n_confirmed; ++i) {
+                    const int n_tokens = whisper_full_n_tokens_from_state(session.state, i);
+                    for (int j = 0; j < n_tokens; ++j) {
+                        const whisper_token id = whisper_full_get_token_id_from_state(session.state, i, j);
+                        if (id < whisper_token_eot(ctx)) {
+                            session.prompt_tokens.push_back(id);
+                        }
+                    }
+                }
+                const size_t max_prompt = (size_t) (params.max_context >= 0 ? params.max_context : 224);
+                if (session.prompt_tokens.size() > max_prompt) {
+                    session.prompt_tokens.erase(
+                        session.prompt_tokens.begin(),
+                        session.prompt_tokens.end() - max_prompt);
+                }
+
+                // trim audio behind the last confirmed segment, keeping a small
+                // overlap so the next decode re-anchors cleanly
+                const int64_t t1_conf = whisper_full_get_segment_t1_from_state(session.state, n_confirmed - 1);
+                const size_t overlap_samples = (200 * WHISPER_SAMPLE_RATE) / 1000; // 200ms
+                size_t cut_samples = (size_t) (t1_conf * (WHISPER_SAMPLE_RATE / 100));
+                cut_samples = cut_samples > overlap_samples ? cut_samples - overlap_samples : 0;
+                if (cut_samples > audio_buffer.size()) {
+                    cut_samples = audio_buffer.size();
+                }
+                if (cut_samples > 0) {
+                    audio_buffer.erase(audio_buffer.begin(), audio_buffer.begin() + cut_samples);
+                    session.t_offset += cut_samples / (WHISPER_SAMPLE_RATE / 100);
+                }
+            }
+        }
+
+        response["session_id"] = session_id;
+        response["buffer_size_ms"] = (audio_buffer.size() * 1000) / 16000;
+        return response;
+    }
+
+    // Only process if we have enough audio data
+    if (audio_buffer.size() >= min_samples) {
+        // Run inference
+        whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+        wparams.print_progress = false;
+        wparams.print_special = params.print_special;
+        wparams.language = params.language.c_str();
+        wparams.n_threads = params.n_threads;
+
+        if (whisper_full_with_state(ctx, session.state, wparams, audio_buffer.data(), audio_buffer.size()) != 0) {
+            return json{{"error", "failed to process audio"}};
+        }
+
+        // Get transcription
+        const int n_segments = whisper_full_n_segments_from_state(session.state);
+
+        for (int i = 0; i < n_segments; ++i) {
+            const char* text = whisper_full_get_segment_text_from_state(session.state, i);
+            const int64_t t0 = whisper_full_get_segment_t0_from_state(session.state, i);
+            const int64_t t1 = whisper_full_get_segment_t1_from_state(session.state, i);
+
+            json segment;
+            segment["text"] = text;
+            segment["t0"] = t0;
+            segment["t1"] = t1;
+            session.push_event(segment.dump());
+            response["segments"].push_back(segment);
+        }
+
+        // Keep a small overlap for context
+        const size_t overlap_samples = (200 * WHISPER_SAMPLE_RATE) / 1000; // 200ms overlap
+        if (audio_buffer.size() > overlap_samples) {
+            audio_buffer.erase(audio_buffer.begin(), audio_buffer.end() - overlap_samples);
+        } else {
+            audio_buffer.clear();
+        }
+    }
+
+    response["session_id"] = session_id;
+    response["buffer_size_ms"] = (audio_buffer.size() * 1000) / 16000;
+    return response;
+}
+
 void check_ffmpeg_availibility() {
     int result = system("ffmpeg -version");
 
@@ -250,21 +1056,680 @@ bool convert_to_wav(const std::string & temp_filename, std::string & error_resp)
     return true;
 }
 
-std::string estimate_diarization_speaker(std::vector<std::vector<float>> pcmf32s, int64_t t0, int64_t t1, bool id_only = false) {
-    std::string speaker = "";
-    const int64_t n_samples = pcmf32s[0].size();
+// Linear resampler used by the in-process decode stage. Quality is fine for
+// speech being fed to whisper; anything fancier belongs in a real DSP library.
+// Pool of PCM sample buffers, mirroring the AudioBufferPool the Tauri side
+// uses for capture: buffers are grouped into power-of-two size classes and
+// recycled with their capacity intact, so a long-lived server does not pay
+// a grow/copy/free cycle - and the heap fragmentation it leaves behind -
+// for every hour-long upload.
+struct pcm_buffer_pool {
+    std::mutex mutex;
+    std::map<size_t, std::deque<std::vector<float>>> classes; // keyed by capacity class
+    size_t max_per_class = 4;
+    size_t max_total_bytes = 256 * 1024 * 1024; // aggregate cap across all classes
+    size_t total_bytes = 0;                     // pooled capacity currently held
+
+    static size_t class_floor(size_t n) {
+        size_t c = 1024;
+        while (c * 2 <= n) {
+            c <<= 1;
+        }
+        return c;
+    }
+
+    static size_t class_ceil(size_t n) {
+        size_t c = 1024;
+        while (c < n) {
+            c <<= 1;
+        }
+        return c;
+    }
+
+    // hands out an empty buffer with capacity for at least n_hint samples,
+    // reusing a pooled one when a large enough class has any
+    std::vector<float> acquire(size_t n_hint) {
+        const size_t want = class_ceil(n_hint);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto it = classes.lower_bound(want); it != classes.end(); ++it) {
+                if (!it->second.empty()) {
+                    std::vector<float> buf = std::move(it->second.front());
+                    it->second.pop_front();
+                    total_bytes -= buf.capacity() * sizeof(float);
+                    buf.clear();
+                    return buf;
+                }
+            }
+        }
+        std::vector<float> buf;
+        buf.reserve(want);
+        return buf;
+    }
+
+    void release(std::vector<float> && buf) {
+        if (buf.capacity() < 1024) {
+            return; // not worth keeping
+        }
+        buf.clear();
+        const size_t cls   = class_floor(buf.capacity());
+        const size_t bytes = buf.capacity() * sizeof(float);
+        std::lock_guard<std::mutex> lock(mutex);
+        auto & q = classes[cls];
+        if (q.size() >= max_per_class) {
+            return; // class full: the buffer is dropped and deallocated here
+        }
+        q.push_back(std::move(buf));
+        total_bytes += bytes;
+
+        // bound the aggregate pooled capacity: after a batch of hour-long
+        // uploads the per-class cap alone would pin several multi-hundred-MB
+        // buffers for the life of the server. Evict from the largest classes
+        // first - that is where the bytes are.
+        while (total_bytes > max_total_bytes) {
+            auto largest = classes.rbegin();
+            while (largest != classes.rend() && largest->second.empty()) {
+                ++largest;
+            }
+            if (largest == classes.rend()) {
+                break;
+            }
+            total_bytes -= largest->second.back().capacity() * sizeof(float);
+            largest->second.pop_back();
+        }
+    }
+};
+
+// returns a request's audio buffers (mono + any stereo channels) to the
+// pool when the handler scope unwinds, on every exit path
+struct pcm_buffer_returner {
+    pcm_buffer_pool & pool;
+    std::vector<float> & pcmf32;
+    std::vector<std::vector<float>> & pcmf32s;
+
+    ~pcm_buffer_returner() {
+        pool.release(std::move(pcmf32));
+        for (auto & ch : pcmf32s) {
+            pool.release(std::move(ch));
+        }
+    }
+};
+
+std::vector<float> resample_linear(const std::vector<float> & in, int rate_in, int rate_out) {
+    if (rate_in == rate_out || in.empty()) {
+        return in;
+    }
+
+    const double ratio = (double) rate_in / rate_out;
+    const size_t n_out = (size_t) (in.size() / ratio);
+
+    std::vector<float> out(n_out);
+    for (size_t i = 0; i < n_out; i++) {
+        const double pos = i * ratio;
+        const size_t i0 = (size_t) pos;
+        const size_t i1 = i0 + 1 < in.size() ? i0 + 1 : i0;
+        const float frac = (float) (pos - i0);
+        out[i] = in[i0] + (in[i1] - in[i0]) * frac;
+    }
+    return out;
+}
+
+// In-process WAV decoder: parses the RIFF header once, then decodes any
+// window of frames on demand. decode_wav_in_memory() runs it over the whole
+// payload; the pipelined long-file path pulls one window at a time so
+// inference of window N can overlap decode of window N+1.
+struct wav_stream_decoder {
+    // raw view so the payload can live in a request body or an mmap'd
+    // spill file alike; the caller keeps the bytes alive while decoding
+    const char * data    = nullptr;
+    size_t       n_bytes = 0;
+
+    uint16_t format_tag      = 0;
+    uint16_t n_channels      = 0;
+    uint32_t sample_rate     = 0;
+    uint16_t bits_per_sample = 0;
+    bool     is_float        = false;
+    size_t   data_offset     = 0;
+    size_t   n_frames        = 0;
+
+    bool init(const char * payload, size_t payload_n, std::string & error) {
+        data    = payload;
+        n_bytes = payload_n;
+
+        auto read_u16 = [&](size_t off) { return (uint16_t) ((uint8_t) payload[off] | ((uint8_t) payload[off + 1] << 8)); };
+        auto read_u32 = [&](size_t off) {
+            return (uint32_t) ((uint8_t) payload[off] | ((uint8_t) payload[off + 1] << 8) |
+                               ((uint8_t) payload[off + 2] << 16) | ((uint8_t) payload[off + 3] << 24));
+        };
+
+        if (payload_n < 44 || memcmp(payload, "RIFF", 4) != 0 || memcmp(payload + 8, "WAVE", 4) != 0) {
+            error = "not a RIFF/WAVE payload";
+            return false;
+        }
+
+        size_t data_size = 0;
+
+        // walk the chunk list for fmt and data
+        size_t off = 12;
+        while (off + 8 <= payload_n) {
+            const char * chunk_id = payload + off;
+            const uint32_t chunk_size = read_u32(off + 4);
+            const size_t chunk_data = off + 8;
+            if (chunk_data + chunk_size > payload_n) {
+                break;
+            }
+
+            if (memcmp(chunk_id, "fmt ", 4) == 0 && chunk_size >= 16) {
+                format_tag      = read_u16(chunk_data);
+                n_channels      = read_u16(chunk_data + 2);
+                sample_rate     = read_u32(chunk_data + 4);
+                bits_per_sample = read_u16(chunk_data + 14);
+                if (format_tag == 0xFFFE && chunk_size >= 40) {
+                    // WAVE_FORMAT_EXTENSIBLE: the real format is in the sub-format GUID
+                    format_tag = read_u16(chunk_data + 24);
+                }
+            } else if (memcmp(chunk_id, "data", 4) == 0) {
+                data_offset = chunk_data;
+                data_size = chunk_size;
+            }
+
+            off = chunk_data + chunk_size + (chunk_size & 1); // chunks are word-aligned
+        }
+
+        if (n_channels == 0 || sample_rate == 0 || data_offset == 0) {
+            error = "malformed WAV: missing fmt or data chunk";
+            return false;
+        }
+
+        is_float = format_tag == 3;
+        if (format_tag != 1 && !is_float) {
+            error = "unsupported WAV format tag " + std::to_string(format_tag);
+            return false;
+        }
+        if (bits_per_sample != 8 && bits_per_sample != 16 && bits_per_sample != 24 &&
+            bits_per_sample != 32) {
+            error = "unsupported WAV bit depth " + std::to_string(bits_per_sample);
+            return false;
+        }
+        if (is_float && bits_per_sample != 32) {
+            error = "unsupported float WAV bit depth " + std::to_string(bits_per_sample);
+            return false;
+        }
+
+        const size_t bytes_per_sample = bits_per_sample / 8;
+        n_frames = data_size / (bytes_per_sample * n_channels);
+
+        return true;
+    }
+
+    // decode [frame_begin, frame_begin + frame_count) into per-channel float
+    // at the source rate
+    void decode_frames(size_t frame_begin, size_t frame_count, std::vector<std::vector<float>> & channels) const {
+        const size_t bytes_per_sample = bits_per_sample / 8;
+
+        channels.assign(n_channels, std::vector<float>());
+        for (auto & ch : channels) {
+            ch.resize(frame_count);
+        }
+
+        const uint8_t * p = (const uint8_t *) data + data_offset + frame_begin * bytes_per_sample * n_channels;
+        for (size_t i = 0; i < frame_count; i++) {
+            for (uint16_t c = 0; c < n_channels; c++) {
+                float sample = 0.0f;
+                switch (bits_per_sample) {
+                    case 8:
+                        sample = ((int) *p - 128) / 128.0f;
+                        break;
+                    case 16:
+                        sample = (int16_t) (p[0] | (p[1] << 8)) / 32768.0f;
+                        break;
+                    case 24: {
+                        int32_t v = p[0] | (p[1] << 8) | (p[2] << 16);
+                        if (v & 0x800000) {
+                            v |= ~0xFFFFFF; // sign-extend
+                        }
+                        sample = v / 8388608.0f;
+                        break;
+                    }
+                    case 32:
+                        if (is_float) {
+                            float f;
+                            memcpy(&f, p, sizeof(f));
+                            sample = f;
+                        } else {
+                            int32_t v;
+                            memcpy(&v, p, sizeof(v));
+                            sample = v / 2147483648.0f;
+                        }
+                        break;
+                }
+                channels[c][i] = sample;
+                p += bytes_per_sample;
+            }
+        }
+    }
+};
+
+// resample each channel to whisper's rate (in place), then mix down to mono
+// into the caller's buffer so pooled capacity is reused
+void mix_to_mono_16k(std::vector<std::vector<float>> & channels, int sample_rate, std::vector<float> & pcmf32) {
+    for (auto & ch : channels) {
+        ch = resample_linear(ch, sample_rate, WHISPER_SAMPLE_RATE);
+    }
+
+    const size_t n_out = channels[0].size();
+    pcmf32.resize(n_out);
+    if (channels.size() == 1) {
+        std::copy(channels[0].begin(), channels[0].end(), pcmf32.begin());
+    } else {
+        for (size_t i = 0; i < n_out; i++) {
+            float sum = 0.0f;
+            for (const auto & ch : channels) {
+                sum += ch[i];
+            }
+            pcmf32[i] = sum / channels.size();
+        }
+    }
+}
+
+// In-process decode stage: parse a RIFF/WAVE payload held in memory and
+// produce 16kHz mono f32 (plus split stereo channels for diarization),
+// replacing the temp-file + ffmpeg shell-out for WAV uploads at any sample
+// rate/width. Returns false with 'error' set if the payload is not a WAV we
+// can decode - the caller may then fall back to ffmpeg for compressed formats.
+bool decode_wav_in_memory(const char * data,
+                          size_t n_bytes,
+                          std::vector<float> & pcmf32,
+                          std::vector<std::vector<float>> & pcmf32s,
+                          bool stereo,
+                          std::string & error) {
+    wav_stream_decoder decoder;
+    if (!decoder.init(data, n_bytes, error)) {
+        return false;
+    }
+
+    std::vector<std::vector<float>> channels;
+    decoder.decode_frames(0, decoder.n_frames, channels);
+
+    mix_to_mono_16k(channels, (int) decoder.sample_rate, pcmf32);
+
+    pcmf32s.clear();
+    if (stereo && decoder.n_channels >= 2) {
+        pcmf32s.push_back(std::move(channels[0]));
+        pcmf32s.push_back(std::move(channels[1]));
+    }
+
+    return true;
+}
+
+// Content-addressed cache of final serialized responses, keyed by a hash of
+// the upload payload plus every inference-relevant parameter. Retries after
+// timeouts and re-summarization runs resubmit identical audio; a hit returns
+// the stored body in milliseconds instead of re-running inference. Entries
+// are optionally mirrored to a directory so they survive restarts.
+struct transcription_cache {
+    struct entry {
+        std::string body;
+        std::string content_type;
+        uint64_t last_used = 0;
+    };
+
+    std::mutex mutex;
+    std::map<std::string, entry> entries;
+    size_t capacity = 0;  // in-memory entries; 0 disables the cache
+    std::string disk_dir; // optional persistent copy
+    uint64_t counter = 0;
+
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+
+    bool enabled() const { return capacity > 0; }
+
+    static uint64_t fnv1a(const void * data, size_t n, uint64_t h) {
+        const uint8_t * p = (const uint8_t *) data;
+        for (size_t i = 0; i < n; i++) {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    static std::string make_key(const char * payload, size_t payload_n, const whisper_params & params) {
+        char fields[512];
+        snprintf(fields, sizeof(fields), "%s|%s|%s|%d|%d|%d|%d|%.3f|%.3f|%d|%d|%d|%d|%d|%d|%d|%d|%d|%.3f|%d|%d|%d|%d|%.3f|%.3f|%.3f",
+                 params.model.c_str(), params.language.c_str(), params.response_format.c_str(),
+                 params.translate, params.detect_language,
+                 params.beam_size, params.best_of,
+                 params.temperature, params.temperature_inc,
+                 params.no_timestamps, params.max_len, params.split_on_word, params.max_context,
+                 params.offset_t_ms, params.duration_ms,
+                 params.diarize, params.tinydiarize,
+                 params.vad, params.vad_thold,
+                 params.suppress_nst, params.pipeline,
+                 params.offset_n, params.audio_ctx,
+                 params.word_thold, params.entropy_thold, params.logprob_thold);
+
+        uint64_t h = fnv1a(payload, payload_n, 1469598103934665603ull);
+        h = fnv1a(fields, strlen(fields), h);
+        h = fnv1a(params.prompt.data(), params.prompt.size(), h);
+
+        char key[17];
+        snprintf(key, sizeof(key), "%016llx", (unsigned long long) h);
+        return key;
+    }
+
+    bool get(const std::string & key, std::string & body, std::string & content_type) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = entries.find(key);
+            if (it != entries.end()) {
+                it->second.last_used = ++counter;
+                body = it->second.body;
+                content_type = it->second.content_type;
+                hits++;
+                return true;
+            }
+        }
+
+        // miss in memory: a previous run may have left the entry on disk
+        if (!disk_dir.empty()) {
+            std::ifstream f(disk_dir + "/" + key + ".cache", std::ios::binary);
+            if (f.good()) {
+                std::getline(f, content_type); // first line is the content type
+                std::stringstream ss;
+                ss << f.rdbuf();
+                body = ss.str();
+                put(key, body, content_type, /*write_disk*/ false);
+                hits++;
+                return true;
+            }
+        }
+
+        misses++;
+        return false;
+    }
+
+    void put(const std::string & key, const std::string & body, const std::string & content_type, bool write_disk = true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            entry & e = entries[key];
+            e.body = body;
+            e.content_type = content_type;
+            e.last_used = ++counter;
+
+            while (entries.size() > capacity) {
+                auto lru = entries.begin();
+                for (auto it = entries.begin(); it != entries.end(); ++it) {
+                    if (it->second.last_used < lru->second.last_used) {
+                        lru = it;
+                    }
+                }
+                entries.erase(lru);
+            }
+        }
+
+        if (write_disk && !disk_dir.empty()) {
+            std::ofstream f(disk_dir + "/" + key + ".cache", std::ios::binary);
+            f << content_type << "\n" << body;
+        }
+    }
+};
+
+// One /inference upload, filled by the streaming multipart reader. Small
+// uploads stay in a memory buffer; past the spill threshold the bytes go to
+// a temp file as httplib delivers them, and finalize() memory-maps that file
+// read-only. Either way data()/size() expose one contiguous view, so peak
+// resident memory for a large upload is whatever the kernel keeps paged in
+// behind the decoder's sequential reads - not the full recording. The
+// destructor unmaps and deletes the spill file on every handler exit path.
+struct upload_buffer {
+    size_t threshold; // spill past this many bytes; 0 = never spill
+
+    std::string memory;
+    std::string spill_path;
+    FILE * spill_file = nullptr;
+    size_t n_written = 0;
+
+    void * map_addr = nullptr;
+    size_t map_size = 0;
+
+    explicit upload_buffer(size_t threshold) : threshold(threshold) {}
+
+    bool append(const char * chunk, size_t n) {
+#ifndef _WIN32
+        if (spill_file == nullptr && threshold > 0 && n_written + n > threshold) {
+            static std::atomic<uint64_t> spill_counter{0};
+            spill_path = "whisper-server-upload-" +
+                         std::to_string(spill_counter.fetch_add(1)) + ".tmp";
+            spill_file = fopen(spill_path.c_str(), "wb");
+            if (spill_file == nullptr) {
+                return false;
+            }
+            fprintf(stderr, "[INFO] Upload exceeds %zu MB, spilling to '%s'\n",
+                    threshold / (1024 * 1024), spill_path.c_str());
+            fflush(stderr);
+
+            // move what was buffered so far, then keep streaming
+            if (!memory.empty() &&
+                fwrite(memory.data(), 1, memory.size(), spill_file) != memory.size()) {
+                return false;
+            }
+            memory.clear();
+            memory.shrink_to_fit();
+        }
+#endif
+        n_written += n;
+        if (spill_file != nullptr) {
+            return fwrite(chunk, 1, n, spill_file) == n;
+        }
+        memory.append(chunk, n);
+        return true;
+    }
+
+    // close the spill file and map it; a no-op for in-memory uploads
+    bool finalize() {
+        if (spill_file == nullptr) {
+            return true;
+        }
+        fclose(spill_file);
+        spill_file = nullptr;
+#ifndef _WIN32
+        int fd = open(spill_path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        void * addr = mmap(nullptr, n_written, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd); // the mapping keeps its own reference
+        if (addr == MAP_FAILED) {
+            return false;
+        }
+        madvise(addr, n_written, MADV_SEQUENTIAL); // decoders read front to back
+        map_addr = addr;
+        map_size = n_written;
+#endif
+        return true;
+    }
+
+    const char * data() const { return map_addr ? (const char *) map_addr : memory.data(); }
+    size_t       size() const { return map_addr ? map_size : memory.size(); }
+
+    ~upload_buffer() {
+        if (spill_file) {
+            fclose(spill_file);
+        }
+#ifndef _WIN32
+        if (map_addr) {
+            munmap(map_addr, map_size);
+        }
+#endif
+        if (!spill_path.empty()) {
+            std::remove(spill_path.c_str());
+        }
+    }
+};
+
+// One decoded window of a long recording, handed from the decode thread to
+// the inference loop
+struct pcm_window {
+    std::vector<float> samples;  // 16kHz mono
+    int64_t t_offset_cs = 0;     // window start on the recording's timeline, centiseconds
+};
+
+// Bounded hand-off between the window decoder and the inference loop: depth 2
+// is enough to keep both stages busy without buffering the whole recording
+// twice.
+struct pcm_window_queue {
+    std::mutex mutex;
+    std::condition_variable cv_space;
+    std::condition_variable cv_data;
+    std::deque<pcm_window> windows;
+    size_t max_depth = 2;
+    bool done = false;
+
+    void push(pcm_window && window) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv_space.wait(lock, [&] { return windows.size() < max_depth; });
+        windows.push_back(std::move(window));
+        cv_data.notify_one();
+    }
+
+    bool pop(pcm_window & out) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv_data.wait(lock, [&] { return !windows.empty() || done; });
+        if (windows.empty()) {
+            return false;
+        }
+        out = std::move(windows.front());
+        windows.pop_front();
+        cv_space.notify_one();
+        return true;
+    }
+
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+        }
+        cv_data.notify_all();
+    }
+};
+
+// A kept speech region, in samples on the original recording's timeline
+struct vad_span {
+    size_t start;
+    size_t end;
+};
+
+// Energy-based VAD pre-filter for the batch path. Works in 30ms frames: a
+// frame counts as speech when its RMS exceeds vad_thold times the recording's
+// mean RMS. Spans are padded by 200ms on both sides and gaps shorter than
+// 300ms are bridged so words are never clipped at span edges.
+std::vector<vad_span> vad_detect_speech(const std::vector<float> & pcmf32, float vad_thold) {
+    const size_t n_frame = (30 * WHISPER_SAMPLE_RATE) / 1000;
+    const size_t n_frames = pcmf32.size() / n_frame;
+
+    std::vector<vad_span> spans;
+    if (n_frames == 0) {
+        return spans;
+    }
+
+    std::vector<float> frame_rms(n_frames);
+    double rms_sum = 0.0;
+    for (size_t f = 0; f < n_frames; f++) {
+        double energy = 0.0;
+        for (size_t i = f * n_frame; i < (f + 1) * n_frame; i++) {
+            energy += (double) pcmf32[i] * pcmf32[i];
+        }
+        frame_rms[f] = (float) sqrt(energy / n_frame);
+        rms_sum += frame_rms[f];
+    }
+    const float rms_mean = (float) (rms_sum / n_frames);
+    const float thold = vad_thold * rms_mean;
+
+    const size_t pad_samples = (200 * WHISPER_SAMPLE_RATE) / 1000; // 200ms
+    const size_t gap_samples = (300 * WHISPER_SAMPLE_RATE) / 1000; // merge gaps < 300ms
+
+    for (size_t f = 0; f < n_frames; f++) {
+        if (frame_rms[f] <= thold) {
+            continue;
+        }
 
-    const int64_t is0 = timestamp_to_sample(t0, n_samples, WHISPER_SAMPLE_RATE);
-    const int64_t is1 = timestamp_to_sample(t1, n_samples, WHISPER_SAMPLE_RATE);
+        size_t start = f * n_frame;
+        start = start > pad_samples ? start - pad_samples : 0;
+        size_t end = (f + 1) * n_frame + pad_samples;
+        if (end > pcmf32.size()) {
+            end = pcmf32.size();
+        }
+
+        if (!spans.empty() && start <= spans.back().end + gap_samples) {
+            spans.back().end = end;
+        } else {
+            spans.push_back({start, end});
+        }
+    }
 
-    double energy0 = 0.0f;
-    double energy1 = 0.0f;
+    return spans;
+}
 
-    for (int64_t j = is0; j < is1; j++) {
-        energy0 += fabs(pcmf32s[0][j]);
-        energy1 += fabs(pcmf32s[1][j]);
+// maps a timestamp (centiseconds) on the VAD-filtered timeline back to the
+// original recording; identity when VAD did not remove anything
+int64_t map_vad_timestamp(const std::vector<vad_span> & spans, int64_t t) {
+    if (spans.empty() || t < 0) {
+        return t;
+    }
+    const int64_t sample = t * (WHISPER_SAMPLE_RATE / 100);
+    int64_t filtered_pos = 0;
+    for (const auto & span : spans) {
+        const int64_t span_len = (int64_t) (span.end - span.start);
+        if (sample < filtered_pos + span_len || &span == &spans.back()) {
+            int64_t orig = (int64_t) span.start + (sample - filtered_pos);
+            if (orig > (int64_t) span.end) {
+                orig = (int64_t) span.end;
+            }
+            return orig / (WHISPER_SAMPLE_RATE / 100);
+        }
+        filtered_pos += span_len;
+    }
+    return t;
+}
+
+// Per-request energy index for diarization: one prefix-sum array of |sample|
+// per stereo channel, built once after the audio is decoded. The speaker
+// estimate runs once per segment in every diarized output path (text, SRT,
+// VTT, realtime print), so each comparison must not rescan the samples -
+// with the prefix sums it is two subtractions per channel.
+struct diarization_energy_index {
+    std::vector<double> prefix0; // prefix0[i] = sum of |ch0[0..i)|
+    std::vector<double> prefix1;
+    int64_t n_samples = 0;
+
+    void build(const std::vector<std::vector<float>> & pcmf32s) {
+        if (pcmf32s.size() != 2) {
+            return;
+        }
+        n_samples = pcmf32s[0].size();
+        prefix0.resize(n_samples + 1);
+        prefix1.resize(n_samples + 1);
+        prefix0[0] = 0.0;
+        prefix1[0] = 0.0;
+        for (int64_t i = 0; i < n_samples; i++) {
+            prefix0[i + 1] = prefix0[i] + fabs(pcmf32s[0][i]);
+            prefix1[i + 1] = prefix1[i] + fabs(pcmf32s[1][i]);
+        }
     }
 
+    bool ready() const { return n_samples > 0; }
+};
+
+std::string estimate_diarization_speaker(const diarization_energy_index & energy, int64_t t0, int64_t t1, bool id_only = false) {
+    std::string speaker = "";
+
+    const int64_t is0 = timestamp_to_sample(t0, energy.n_samples, WHISPER_SAMPLE_RATE);
+    const int64_t is1 = timestamp_to_sample(t1, energy.n_samples, WHISPER_SAMPLE_RATE);
+
+    const double energy0 = energy.prefix0[is1] - energy.prefix0[is0];
+    const double energy1 = energy.prefix1[is1] - energy.prefix1[is0];
+
     if (energy0 > 1.1*energy1) {
         speaker = "0";
     } else if (energy1 > 1.1*energy0) {
@@ -292,11 +1757,11 @@ void whisper_print_progress_callback(struct whisper_context * /*ctx*/, struct wh
     }
 }
 
-void whisper_print_segment_callback(struct whisper_context * ctx, struct whisper_state * /*state*/, int n_new, void * user_data) {
-    const auto & params  = *((whisper_print_user_data *) user_data)->params;
-    const auto & pcmf32s = *((whisper_print_user_data *) user_data)->pcmf32s;
+void whisper_print_segment_callback(struct whisper_context * ctx, struct whisper_state * state, int n_new, void * user_data) {
+    const auto & params = *((whisper_print_user_data *) user_data)->params;
+    const auto & energy = *((whisper_print_user_data *) user_data)->energy;
 
-    const int n_segments = whisper_full_n_segments(ctx);
+    const int n_segments = whisper_full_n_segments_from_state(state);
 
     std::string speaker = "";
 
@@ -312,42 +1777,42 @@ void whisper_print_segment_callback(struct whisper_context * ctx, struct whisper
 
     for (int i = s0; i < n_segments; i++) {
         if (!params.no_timestamps || params.diarize) {
-            t0 = whisper_full_get_segment_t0(ctx, i);
-            t1 = whisper_full_get_segment_t1(ctx, i);
+            t0 = whisper_full_get_segment_t0_from_state(state, i);
+            t1 = whisper_full_get_segment_t1_from_state(state, i);
         }
 
         if (!params.no_timestamps) {
             printf("[%s --> %s]  ", to_timestamp(t0).c_str(), to_timestamp(t1).c_str());
         }
 
-        if (params.diarize && pcmf32s.size() == 2) {
-            speaker = estimate_diarization_speaker(pcmf32s, t0, t1);
+        if (params.diarize && energy.ready()) {
+            speaker = estimate_diarization_speaker(energy, t0, t1);
         }
 
         if (params.print_colors) {
-            for (int j = 0; j < whisper_full_n_tokens(ctx, i); ++j) {
+            for (int j = 0; j < whisper_full_n_tokens_from_state(state, i); ++j) {
                 if (params.print_special == false) {
-                    const whisper_token id = whisper_full_get_token_id(ctx, i, j);
+                    const whisper_token id = whisper_full_get_token_id_from_state(state, i, j);
                     if (id >= whisper_token_eot(ctx)) {
                         continue;
                     }
                 }
 
-                const char * text = whisper_full_get_token_text(ctx, i, j);
-                const float  p    = whisper_full_get_token_p   (ctx, i, j);
+                const char * text = whisper_full_get_token_text_from_state(ctx, state, i, j);
+                const float  p    = whisper_full_get_token_p_from_state   (state, i, j);
 
                 const int col = std::max(0, std::min((int) k_colors.size() - 1, (int) (std::pow(p, 3)*float(k_colors.size()))));
 
                 printf("%s%s%s%s", speaker.c_str(), k_colors[col].c_str(), text, "\033[0m");
             }
         } else {
-            const char * text = whisper_full_get_segment_text(ctx, i);
+            const char * text = whisper_full_get_segment_text_from_state(state, i);
 
             printf("%s%s", speaker.c_str(), text);
         }
 
         if (params.tinydiarize) {
-            if (whisper_full_get_segment_speaker_turn_next(ctx, i)) {
+            if (whisper_full_get_segment_speaker_turn_next_from_state(state, i)) {
                 printf("%s", params.tdrz_speaker_turn.c_str());
             }
         }
@@ -360,18 +1825,18 @@ void whisper_print_segment_callback(struct whisper_context * ctx, struct whisper
     }
 }
 
-std::string output_str(struct whisper_context * ctx, const whisper_params & params, std::vector<std::vector<float>> pcmf32s) {
+std::string output_str(struct whisper_state * state, const whisper_params & params, const diarization_energy_index & energy) {
     std::stringstream result;
-    const int n_segments = whisper_full_n_segments(ctx);
+    const int n_segments = whisper_full_n_segments_from_state(state);
     for (int i = 0; i < n_segments; ++i) {
-        const char * text = whisper_full_get_segment_text(ctx, i);
+        const char * text = whisper_full_get_segment_text_from_state(state, i);
         std::string speaker = "";
 
-        if (params.diarize && pcmf32s.size() == 2)
+        if (params.diarize && energy.ready())
         {
-            const int64_t t0 = whisper_full_get_segment_t0(ctx, i);
-            const int64_t t1 = whisper_full_get_segment_t1(ctx, i);
-            speaker = estimate_diarization_speaker(pcmf32s, t0, t1);
+            const int64_t t0 = whisper_full_get_segment_t0_from_state(state, i);
+            const int64_t t1 = whisper_full_get_segment_t1_from_state(state, i);
+            speaker = estimate_diarization_speaker(energy, t0, t1);
         }
 
         result << speaker << text << "\n";
@@ -379,6 +1844,246 @@ std::string output_str(struct whisper_context * ctx, const whisper_params & para
     return result.str();
 }
 
+// serialize one decoded segment in openai/whisper's verbose_json shape;
+// called per segment by the chunked response writer below
+json vjson_segment(struct whisper_context * ctx, struct whisper_state * state,
+                   const whisper_params & params, const std::vector<vad_span> & vad_spans, int i) {
+    json segment = json{
+        {"id", i},
+        {"text", whisper_full_get_segment_text_from_state(state, i)},
+    };
+
+    if (!params.no_timestamps) {
+        segment["start"] = map_vad_timestamp(vad_spans, whisper_full_get_segment_t0_from_state(state, i)) * 0.01;
+        segment["end"]   = map_vad_timestamp(vad_spans, whisper_full_get_segment_t1_from_state(state, i)) * 0.01;
+    }
+
+    float total_logprob = 0;
+    const int n_tokens = whisper_full_n_tokens_from_state(state, i);
+    for (int j = 0; j < n_tokens; ++j) {
+        whisper_token_data token = whisper_full_get_token_data_from_state(state, i, j);
+        if (token.id >= whisper_token_eot(ctx)) {
+            continue;
+        }
+
+        segment["tokens"].push_back(token.id);
+        json word = json{{"word", whisper_full_get_token_text_from_state(ctx, state, i, j)}};
+        if (!params.no_timestamps) {
+            word["start"] = map_vad_timestamp(vad_spans, token.t0) * 0.01;
+            word["end"] = map_vad_timestamp(vad_spans, token.t1) * 0.01;
+            word["t_dtw"] = token.t_dtw >= 0 ? map_vad_timestamp(vad_spans, token.t_dtw) : token.t_dtw;
+        }
+        word["probability"] = token.p;
+        total_logprob += token.plog;
+        segment["words"].push_back(word);
+    }
+
+    segment["temperature"] = params.temperature;
+    segment["avg_logprob"] = total_logprob / n_tokens;
+
+    // TODO compression_ratio and no_speech_prob are not implemented yet
+    // segment["compression_ratio"] = 0;
+    segment["no_speech_prob"] = whisper_full_get_segment_no_speech_prob_from_state(state, i);
+
+    return segment;
+}
+
+// little-endian byte writers for the "binary" response format; explicit
+// byte order so the payload is identical regardless of the host
+void bin_append_u32(std::string & out, uint32_t v) {
+    const char b[4] = {
+        char(v & 0xff), char((v >> 8) & 0xff), char((v >> 16) & 0xff), char((v >> 24) & 0xff),
+    };
+    out.append(b, 4);
+}
+
+void bin_append_i64(std::string & out, int64_t v) {
+    const uint64_t u = (uint64_t) v;
+    bin_append_u32(out, (uint32_t) (u & 0xffffffffu));
+    bin_append_u32(out, (uint32_t) (u >> 32));
+}
+
+void bin_append_f32(std::string & out, float v) {
+    uint32_t u;
+    memcpy(&u, &v, sizeof(u));
+    bin_append_u32(out, u);
+}
+
+// Compact binary transcript ("binary" response_format) for token-level
+// payloads - roughly 5x smaller than verbose_json and fixed-width, so the
+// client can index records without parsing. Layout, all little-endian:
+//
+//   header  : magic "WSBT", uint32 version (1), uint32 n_segments,
+//             uint32 n_tokens, uint32 string-table bytes
+//   records : n_tokens x { int64 t0, int64 t1, int32 token_id, float prob,
+//             uint32 segment, uint32 text_off, uint32 text_len }
+//   table   : concatenated UTF-8 token texts, deduplicated via offsets
+//
+// Timestamps are centiseconds (already VAD-remapped), -1 when token-level
+// timestamps were not computed.
+std::string output_binary(struct whisper_context * ctx, struct whisper_state * state,
+                          const std::vector<vad_span> & vad_spans) {
+    std::string records;
+    std::string table;
+    std::map<std::string, uint32_t> interned;
+
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    uint32_t n_tokens = 0;
+
+    for (int i = 0; i < n_segments; ++i) {
+        const int n = whisper_full_n_tokens_from_state(state, i);
+        for (int j = 0; j < n; ++j) {
+            const whisper_token_data token = whisper_full_get_token_data_from_state(state, i, j);
+            if (token.id >= whisper_token_eot(ctx)) {
+                continue;
+            }
+
+            const std::string text = whisper_full_get_token_text_from_state(ctx, state, i, j);
+            auto it = interned.find(text);
+            if (it == interned.end()) {
+                it = interned.emplace(text, (uint32_t) table.size()).first;
+                table += text;
+            }
+
+            bin_append_i64(records, token.t0 >= 0 ? map_vad_timestamp(vad_spans, token.t0) : token.t0);
+            bin_append_i64(records, token.t1 >= 0 ? map_vad_timestamp(vad_spans, token.t1) : token.t1);
+            bin_append_u32(records, (uint32_t) token.id);
+            bin_append_f32(records, token.p);
+            bin_append_u32(records, (uint32_t) i);
+            bin_append_u32(records, it->second);
+            bin_append_u32(records, (uint32_t) text.size());
+            n_tokens++;
+        }
+    }
+
+    std::string blob = "WSBT";
+    bin_append_u32(blob, 1);
+    bin_append_u32(blob, (uint32_t) n_segments);
+    bin_append_u32(blob, n_tokens);
+    bin_append_u32(blob, (uint32_t) table.size());
+    blob += records;
+    blob += table;
+
+    return blob;
+}
+
+// Everything the chunked verbose_json writer needs after the request handler
+// returns: the content provider runs as the socket drains, so the worker
+// state and model entry stay pinned here until the response completes.
+struct vjson_streamer {
+    std::shared_ptr<model_entry> model;
+    std::shared_ptr<whisper_state_guard> guard;
+    whisper_params params;
+    std::vector<vad_span> vad_spans;
+    std::string head;
+    int n_segments = 0;
+    int next = 0;
+};
+
+// translate request-level whisper_params into whisper_full_params; callbacks
+// and format-dependent fields are wired by the caller
+whisper_full_params make_full_params(const whisper_params & params) {
+    whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+
+    wparams.strategy = params.beam_size > 1 ? WHISPER_SAMPLING_BEAM_SEARCH : WHISPER_SAMPLING_GREEDY;
+
+    wparams.print_realtime   = false;
+    wparams.print_progress   = params.print_progress;
+    wparams.print_timestamps = !params.no_timestamps;
+    wparams.print_special    = params.print_special;
+    wparams.translate        = params.translate;
+    wparams.language         = params.language.c_str();
+    wparams.n_threads        = params.n_threads;
+    wparams.n_max_text_ctx   = params.max_context >= 0 ? params.max_context : wparams.n_max_text_ctx;
+    wparams.offset_ms        = params.offset_t_ms;
+    wparams.duration_ms      = params.duration_ms;
+
+    wparams.thold_pt         = params.word_thold;
+    wparams.max_len          = params.max_len == 0 ? 60 : params.max_len;
+    wparams.split_on_word    = params.split_on_word;
+    wparams.audio_ctx        = params.audio_ctx;
+
+    wparams.debug_mode       = params.debug_mode;
+
+    wparams.tdrz_enable      = params.tinydiarize; // [TDRZ]
+
+    wparams.initial_prompt   = params.prompt.c_str();
+
+    wparams.greedy.best_of        = params.best_of;
+    wparams.beam_search.beam_size = params.beam_size;
+
+    wparams.temperature      = params.temperature;
+    wparams.no_speech_thold  = params.no_speech_thold;
+    wparams.temperature_inc  = params.temperature_inc;
+    wparams.entropy_thold    = params.entropy_thold;
+    wparams.logprob_thold    = params.logprob_thold;
+
+    wparams.no_timestamps    = params.no_timestamps;
+
+    wparams.suppress_nst     = params.suppress_nst;
+
+    return wparams;
+}
+
+// A stream_json decode in flight: the decode thread produces one SSE event
+// per newly decoded segment, the chunked response writer consumes them. The
+// job pins the worker state, the model entry and the admission ticket until
+// both sides are done.
+struct stream_json_job {
+    std::shared_ptr<model_entry> model;
+    std::shared_ptr<whisper_state_guard> guard;
+    std::shared_ptr<admission_ticket> ticket;
+    whisper_params params;
+    std::vector<float> pcmf32;
+    std::vector<vad_span> vad_spans;
+
+    // the request's abort token; also flipped when the SSE client
+    // disconnects, so the decode thread stops instead of transcribing the
+    // rest of the file for nobody
+    std::shared_ptr<std::atomic<bool>> abort;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::string> events;
+    bool done = false;
+
+    void push_event(const std::string & event) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            events.push_back(event);
+        }
+        cv.notify_all();
+    }
+
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+        }
+        cv.notify_all();
+    }
+};
+
+// new_segment_callback for stream_json: serialize each fresh segment the
+// moment the decoder emits it, so the client sees text while the tail of
+// the recording is still transcribing
+void stream_json_new_segment(struct whisper_context * /*ctx*/, struct whisper_state * state, int n_new, void * user_data) {
+    auto * job = (stream_json_job *) user_data;
+
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    for (int i = n_segments - n_new; i < n_segments; i++) {
+        json segment = json{
+            {"id", i},
+            {"text", whisper_full_get_segment_text_from_state(state, i)},
+        };
+        if (!job->params.no_timestamps) {
+            segment["start"] = map_vad_timestamp(job->vad_spans, whisper_full_get_segment_t0_from_state(state, i)) * 0.01;
+            segment["end"]   = map_vad_timestamp(job->vad_spans, whisper_full_get_segment_t1_from_state(state, i)) * 0.01;
+        }
+        job->push_event(segment.dump(-1, ' ', false, json::error_handler_t::replace));
+    }
+}
+
 bool parse_str_to_bool(const std::string & s) {
     if (s == "true" || s == "1" || s == "yes" || s == "y") {
         return true;
@@ -386,107 +2091,136 @@ bool parse_str_to_bool(const std::string & s) {
     return false;
 }
 
-void get_req_parameters(const Request & req, whisper_params & params)
+void get_req_parameters(const MultipartFormDataMap & files, whisper_params & params)
 {
-    if (req.has_file("offset_t"))
+    // same accessors as httplib::Request exposes, over the part map collected
+    // by the streaming multipart reader (the audio payload is kept out of it)
+    auto has_file = [&](const std::string & name) {
+        return files.find(name) != files.end();
+    };
+    auto get_file_value = [&](const std::string & name) -> const MultipartFormData & {
+        return files.find(name)->second;
+    };
+
+    if (has_file("offset_t"))
+    {
+        params.offset_t_ms = std::stoi(get_file_value("offset_t").content);
+    }
+    if (has_file("offset_n"))
+    {
+        params.offset_n = std::stoi(get_file_value("offset_n").content);
+    }
+    if (has_file("duration"))
+    {
+        params.duration_ms = std::stoi(get_file_value("duration").content);
+    }
+    if (has_file("max_context"))
+    {
+        params.max_context = std::stoi(get_file_value("max_context").content);
+    }
+    if (has_file("max_len"))
+    {
+        params.max_len = std::stoi(get_file_value("max_len").content);
+    }
+    if (has_file("best_of"))
     {
-        params.offset_t_ms = std::stoi(req.get_file_value("offset_t").content);
+        params.best_of = std::stoi(get_file_value("best_of").content);
     }
-    if (req.has_file("offset_n"))
+    if (has_file("beam_size"))
     {
-        params.offset_n = std::stoi(req.get_file_value("offset_n").content);
+        params.beam_size = std::stoi(get_file_value("beam_size").content);
     }
-    if (req.has_file("duration"))
+    if (has_file("audio_ctx"))
     {
-        params.duration_ms = std::stoi(req.get_file_value("duration").content);
+        params.audio_ctx = std::stof(get_file_value("audio_ctx").content);
     }
-    if (req.has_file("max_context"))
+    if (has_file("word_thold"))
     {
-        params.max_context = std::stoi(req.get_file_value("max_context").content);
+        params.word_thold = std::stof(get_file_value("word_thold").content);
     }
-    if (req.has_file("max_len"))
+    if (has_file("entropy_thold"))
     {
-        params.max_len = std::stoi(req.get_file_value("max_len").content);
+        params.entropy_thold = std::stof(get_file_value("entropy_thold").content);
     }
-    if (req.has_file("best_of"))
+    if (has_file("logprob_thold"))
     {
-        params.best_of = std::stoi(req.get_file_value("best_of").content);
+        params.logprob_thold = std::stof(get_file_value("logprob_thold").content);
     }
-    if (req.has_file("beam_size"))
+    if (has_file("debug_mode"))
     {
-        params.beam_size = std::stoi(req.get_file_value("beam_size").content);
+        params.debug_mode = parse_str_to_bool(get_file_value("debug_mode").content);
     }
-    if (req.has_file("audio_ctx"))
+    if (has_file("translate"))
     {
-        params.audio_ctx = std::stof(req.get_file_value("audio_ctx").content);
+        params.translate = parse_str_to_bool(get_file_value("translate").content);
     }
-    if (req.has_file("word_thold"))
+    if (has_file("diarize"))
     {
-        params.word_thold = std::stof(req.get_file_value("word_thold").content);
+        params.diarize = parse_str_to_bool(get_file_value("diarize").content);
     }
-    if (req.has_file("entropy_thold"))
+    if (has_file("tinydiarize"))
     {
-        params.entropy_thold = std::stof(req.get_file_value("entropy_thold").content);
+        params.tinydiarize = parse_str_to_bool(get_file_value("tinydiarize").content);
     }
-    if (req.has_file("logprob_thold"))
+    if (has_file("split_on_word"))
     {
-        params.logprob_thold = std::stof(req.get_file_value("logprob_thold").content);
+        params.split_on_word = parse_str_to_bool(get_file_value("split_on_word").content);
     }
-    if (req.has_file("debug_mode"))
+    if (has_file("no_timestamps"))
     {
-        params.debug_mode = parse_str_to_bool(req.get_file_value("debug_mode").content);
+        params.no_timestamps = parse_str_to_bool(get_file_value("no_timestamps").content);
     }
-    if (req.has_file("translate"))
+    if (has_file("language"))
     {
-        params.translate = parse_str_to_bool(req.get_file_value("translate").content);
+        params.language = get_file_value("language").content;
     }
-    if (req.has_file("diarize"))
+    if (has_file("detect_language"))
     {
-        params.diarize = parse_str_to_bool(req.get_file_value("diarize").content);
+        params.detect_language = parse_str_to_bool(get_file_value("detect_language").content);
     }
-    if (req.has_file("tinydiarize"))
+    if (has_file("prompt"))
     {
-        params.tinydiarize = parse_str_to_bool(req.get_file_value("tinydiarize").content);
+        params.prompt = get_file_value("prompt").content;
     }
-    if (req.has_file("split_on_word"))
+    if (has_file("response_format"))
     {
-        params.split_on_word = parse_str_to_bool(req.get_file_value("split_on_word").content);
+        params.response_format = get_file_value("response_format").content;
     }
-    if (req.has_file("no_timestamps"))
+    if (has_file("temperature"))
     {
-        params.no_timestamps = parse_str_to_bool(req.get_file_value("no_timestamps").content);
+        params.temperature = std::stof(get_file_value("temperature").content);
     }
-    if (req.has_file("language"))
+    if (has_file("temperature_inc"))
     {
-        params.language = req.get_file_value("language").content;
+        params.temperature_inc = std::stof(get_file_value("temperature_inc").content);
     }
-    if (req.has_file("detect_language"))
+    if (has_file("suppress_non_speech"))
     {
-        params.detect_language = parse_str_to_bool(req.get_file_value("detect_language").content);
+        params.suppress_nst = parse_str_to_bool(get_file_value("suppress_non_speech").content);
     }
-    if (req.has_file("prompt"))
+    if (has_file("suppress_nst"))
     {
-        params.prompt = req.get_file_value("prompt").content;
+        params.suppress_nst = parse_str_to_bool(get_file_value("suppress_nst").content);
     }
-    if (req.has_file("response_format"))
+    if (has_file("model"))
     {
-        params.response_format = req.get_file_value("response_format").content;
+        params.model = get_file_value("model").content;
     }
-    if (req.has_file("temperature"))
+    if (has_file("vad"))
     {
-        params.temperature = std::stof(req.get_file_value("temperature").content);
+        params.vad = parse_str_to_bool(get_file_value("vad").content);
     }
-    if (req.has_file("temperature_inc"))
+    if (has_file("vad_thold"))
     {
-        params.temperature_inc = std::stof(req.get_file_value("temperature_inc").content);
+        params.vad_thold = std::stof(get_file_value("vad_thold").content);
     }
-    if (req.has_file("suppress_non_speech"))
+    if (has_file("pipeline"))
     {
-        params.suppress_nst = parse_str_to_bool(req.get_file_value("suppress_non_speech").content);
+        params.pipeline = parse_str_to_bool(get_file_value("pipeline").content);
     }
-    if (req.has_file("suppress_nst"))
+    if (has_file("timing"))
     {
-        params.suppress_nst = parse_str_to_bool(req.get_file_value("suppress_nst").content);
+        params.timing = parse_str_to_bool(get_file_value("timing").content);
     }
 }
 
@@ -522,7 +2256,7 @@ int main(int argc, char ** argv) {
     fflush(stderr);
     fprintf(stderr, "[CONFIG] Model: %s\n", params.model.c_str());
     fprintf(stderr, "[CONFIG] Host: %s:%d\n", sparams.hostname.c_str(), sparams.port);
-    fprintf(stderr, "[CONFIG] Threads: %d, Processors: %d\n", params.n_threads, params.n_processors);
+    fprintf(stderr, "[CONFIG] Threads: %d\n", params.n_threads);
     fprintf(stderr, "[CONFIG] GPU: %s, Flash Attention: %s\n", 
             params.use_gpu ? "enabled" : "disabled",
             params.flash_attn ? "enabled" : "disabled");
@@ -572,23 +2306,99 @@ int main(int argc, char ** argv) {
             cparams.dtw_aheads_preset = WHISPER_AHEADS_LARGE_V3;
         }
 
-        if (cparams.dtw_aheads_preset == WHISPER_AHEADS_NONE) {
-            fprintf(stderr, "error: unknown DTW preset '%s'\n", params.dtw.c_str());
-            return 3;
+        if (cparams.dtw_aheads_preset == WHISPER_AHEADS_NONE) {
+            fprintf(stderr, "error: unknown DTW preset '%s'\n", params.dtw.c_str());
+            return 3;
+        }
+    }
+
+    if (sparams.n_workers < 1) {
+        fprintf(stderr, "error: --workers must be at least 1\n");
+        return 1;
+    }
+    if (sparams.n_models < 1) {
+        fprintf(stderr, "error: --models must be at least 1\n");
+        return 1;
+    }
+
+    // model cache: the startup model is loaded eagerly, additional models are
+    // loaded on first use and evicted LRU beyond --models capacity
+    model_cache models;
+    models.capacity        = (size_t) sparams.n_models;
+    models.cparams         = cparams;
+    models.openvino_device = params.openvino_encode_device;
+    models.n_workers       = sparams.n_workers;
+
+    // --gpu-devices "0,0,1,1" pins one worker state per list entry to that
+    // GPU; the cache keeps a context per device and dispatches each request
+    // to the least-loaded one. Without the flag all workers share one
+    // context on the loader default device, as before.
+    int32_t total_workers = sparams.n_workers;
+    if (!sparams.gpu_devices.empty()) {
+        std::stringstream device_list(sparams.gpu_devices);
+        std::string item;
+        while (std::getline(device_list, item, ',')) {
+            const int32_t device = std::stoi(item);
+            bool found = false;
+            for (auto & dw : models.device_workers) {
+                if (dw.first == device) {
+                    dw.second++;
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                models.device_workers.emplace_back(device, 1);
+            }
+        }
+        if (models.device_workers.empty()) {
+            fprintf(stderr, "error: --gpu-devices needs at least one device index\n");
+            return 1;
+        }
+        total_workers = 0;
+        for (const auto & dw : models.device_workers) {
+            fprintf(stderr, "[CONFIG] GPU %d: %d worker state(s)\n", dw.first, dw.second);
+            total_workers += dw.second;
+        }
+        fflush(stderr);
+    }
+
+    {
+        std::string load_error;
+        auto initial_model = models.get(params.model, load_error);
+        if (initial_model == nullptr) {
+            fprintf(stderr, "[ERROR] Failed to initialize whisper context: %s\n", load_error.c_str());
+            fflush(stderr);
+            return 3;
+        }
+
+        // pay GPU kernel compilation up front, before the port opens - once
+        // per device, since every context compiles its own kernels
+        for (const auto & shard : models.shards_of(params.model)) {
+            warm_up_model(shard, params.n_threads);
         }
     }
+    fprintf(stderr, "[INFO] Successfully initialized whisper context (%d worker state(s), %d model slot(s))\n",
+            total_workers, sparams.n_models);
+    fflush(stderr);
 
-    struct whisper_context * ctx = whisper_init_from_file_with_params(params.model.c_str(), cparams);
+    // backpressure in front of the workers: live chunks outrank batch uploads
+    admission_queue admission;
+    admission.max_active = total_workers;
+    admission.max_depth  = sparams.queue_depth;
 
-    if (ctx == nullptr) {
-        fprintf(stderr, "[ERROR] Failed to initialize whisper context\n");
-        fflush(stderr);
-        return 3;
-    }
-    fprintf(stderr, "[INFO] Successfully initialized whisper context\n");
-    fflush(stderr);
-    // initialize openvino encoder. this has no effect on whisper.cpp builds that don't have OpenVINO configured
-    whisper_ctx_init_openvino_encoder(ctx, nullptr, params.openvino_encode_device.c_str(), nullptr);
+    // abort tokens for in-flight requests, cancellable via DELETE /inference/<id>
+    inflight_registry inflight;
+
+    server_metrics metrics;
+
+    // recycled PCM buffers shared by all inference requests
+    pcm_buffer_pool pcm_pool;
+
+    // serialized responses for repeated identical uploads
+    transcription_cache response_cache;
+    response_cache.capacity = sparams.cache_entries > 0 ? (size_t) sparams.cache_entries : 0;
+    response_cache.disk_dir = sparams.cache_dir;
 
     Server svr;
     svr.set_default_headers({{"Server", "whisper.cpp"},
@@ -678,15 +2488,49 @@ int main(int argc, char ** argv) {
     svr.Options(sparams.request_path + sparams.inference_path, [&](const Request &, Response &){
     });
 
-    svr.Post(sparams.request_path + sparams.inference_path, [&](const Request &req, Response &res){
-        // acquire whisper model mutex lock
-        std::lock_guard<std::mutex> lock(whisper_mutex);
+    svr.Post(sparams.request_path + sparams.inference_path, [&](const Request &req, Response &res, const ContentReader &content_reader){
+        metrics.inference_requests++;
 
         fprintf(stderr, "\n[REQUEST] New inference request received\n");
         fflush(stderr);
 
-        // first check user requested fields of the request
-        if (!req.has_file("file"))
+        // Stream the multipart body instead of letting httplib buffer it
+        // whole: form fields are small and collected into a map, while the
+        // audio payload goes through the upload buffer, which spills to a
+        // temp file past --spill-threshold and is mmap'd for the decoders.
+        // Several concurrent multi-GB uploads then cost page cache, not RSS.
+        upload_buffer upload((size_t) sparams.spill_threshold_mb * 1024 * 1024);
+        MultipartFormDataMap fields;
+        MultipartFormDataMap::iterator field_it = fields.end();
+        std::string audio_filename;
+        bool have_file = false;
+        bool upload_ok = true;
+        bool reading_file = false;
+
+        if (req.is_multipart_form_data()) {
+            content_reader(
+                [&](const MultipartFormData & part) {
+                    reading_file = part.name == "file";
+                    if (reading_file) {
+                        have_file = true;
+                        audio_filename = part.filename;
+                    } else {
+                        field_it = fields.emplace(part.name, part);
+                        field_it->second.content.clear();
+                    }
+                    return true;
+                },
+                [&](const char * chunk, size_t n) {
+                    if (reading_file) {
+                        upload_ok = upload.append(chunk, n);
+                        return upload_ok;
+                    }
+                    field_it->second.content.append(chunk, n);
+                    return true;
+                });
+        }
+
+        if (!have_file)
         {
             fprintf(stderr, "[ERROR] No 'file' field in the request\n");
             fflush(stderr);
@@ -694,29 +2538,256 @@ int main(int argc, char ** argv) {
             res.set_content(error_resp, "application/json");
             return;
         }
-        auto audio_file = req.get_file_value("file");
+        if (!upload_ok || !upload.finalize()) {
+            fprintf(stderr, "[ERROR] Failed to buffer upload (%zu bytes in)\n", upload.n_written);
+            fflush(stderr);
+            metrics.inference_failures++;
+            res.status = 500;
+            res.set_content("{\"error\":\"failed to buffer upload\"}", "application/json");
+            return;
+        }
+
+        // per-request parameter copy - concurrent requests must not mutate
+        // shared state (/load swaps the default model under whisper_mutex)
+        whisper_params params;
+        {
+            std::lock_guard<std::mutex> lock(whisper_mutex);
+            params = default_params;
+        }
 
         // check non-required fields
-        get_req_parameters(req, params);
+        get_req_parameters(fields, params);
+
+        // register an abort token for this request; anonymous uploads (no
+        // request_id) still get one, they just cannot be cancelled by name
+        const auto request_id_it = fields.find("request_id");
+        const std::string request_id = request_id_it != fields.end()
+            ? request_id_it->second.content
+            : "";
+        auto abort_token = inflight.add(request_id);
+        inflight_guard abort_guard(inflight, request_id);
+
+        // duplicate uploads (timeout retries, re-summarization runs) answer
+        // straight from the response cache, skipping admission and inference;
+        // the streamed formats produce no single body to store, and a timing
+        // breakdown is per-run data that must not be replayed from cache
+        const bool cacheable = response_cache.enabled() && !params.timing &&
+            (params.response_format == json_format || params.response_format == text_format ||
+             params.response_format == srt_format  || params.response_format == vtt_format ||
+             params.response_format == bin_format);
+        std::string cache_key;
+        if (cacheable) {
+            cache_key = transcription_cache::make_key(upload.data(), upload.size(), params);
+            std::string cached_body;
+            std::string cached_type;
+            if (response_cache.get(cache_key, cached_body, cached_type)) {
+                fprintf(stderr, "[INFO] Response cache hit (%s)\n", cache_key.c_str());
+                fflush(stderr);
+                res.set_content(cached_body, cached_type.c_str());
+                return;
+            }
+        }
+
+        // time spent waiting for capacity (admission now, a worker state
+        // later) - the usual culprit when tail latency spikes under load
+        uint64_t queue_ms = 0;
+        const auto t_admission_start = std::chrono::steady_clock::now();
+
+        // batch uploads enter the admission queue at low priority; a
+        // shared_ptr so the stream_json decode thread can hold its slot
+        auto ticket = std::make_shared<admission_ticket>(admission, /*high_priority*/ false);
+        queue_ms += (uint64_t) std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - t_admission_start).count();
+        if (!ticket->admitted) {
+            fprintf(stderr, "[WARNING] Inference queue full, rejecting request\n");
+            fflush(stderr);
+            send_queue_full(res, admission);
+            return;
+        }
+
+        // resolve the model for this request - cached entries are shared,
+        // a miss loads the model without disturbing traffic on other models
+        std::string model_error;
+        auto model = models.get(params.model, model_error);
+        if (model == nullptr) {
+            fprintf(stderr, "[ERROR] %s\n", model_error.c_str());
+            fflush(stderr);
+            metrics.inference_failures++;
+            res.status = 400;
+            const std::string error_resp = "{\"error\":\"" + model_error + "\"}";
+            res.set_content(error_resp, "application/json");
+            return;
+        }
+
+        // Pipelined long-file path (opt-in via 'pipeline'): decode the WAV in
+        // ~10-minute windows on a side thread and run inference on window N
+        // while window N+1 is being decoded, stitching segment timestamps
+        // back onto the recording's timeline. VAD and the segment-indexed
+        // response formats need the whole recording in one pass, and
+        // diarization is skipped here, so only json/text requests qualify.
+        if (params.pipeline && !params.vad &&
+            (params.response_format == json_format || params.response_format == text_format)) {
+            wav_stream_decoder decoder;
+            std::string pipeline_error;
+            if (decoder.init(upload.data(), upload.size(), pipeline_error)) {
+                if (params.diarize && decoder.n_channels >= 2) {
+                    fprintf(stderr, "[INFO] Pipeline mode skips diarization for stereo uploads\n");
+                    fflush(stderr);
+                }
+
+                const size_t window_frames = (size_t) 600 * decoder.sample_rate;
+
+                pcm_window_queue queue;
+                std::thread decode_thread([&]() {
+                    std::vector<std::vector<float>> channels;
+                    for (size_t frame = 0; frame < decoder.n_frames; frame += window_frames) {
+                        const size_t count = std::min(window_frames, decoder.n_frames - frame);
+                        decoder.decode_frames(frame, count, channels);
+
+                        pcm_window window;
+                        window.samples = pcm_pool.acquire(count);
+                        mix_to_mono_16k(channels, (int) decoder.sample_rate, window.samples);
+                        window.t_offset_cs = (int64_t) ((frame * 100.0) / decoder.sample_rate);
+                        queue.push(std::move(window));
+                    }
+                    queue.finish();
+                });
+
+                whisper_state_guard state_guard(model->pool);
+
+                json segments = json::array();
+                std::string full_text;
+                bool failed = false;
+
+                {
+                    stage_timer inference_timer(metrics.inference_stage_ms);
+
+                    pcm_window window;
+                    while (!failed && queue.pop(window)) {
+                        if (abort_token->load()) {
+                            failed = true;
+                            break;
+                        }
+
+                        whisper_full_params wparams = make_full_params(params);
+
+                        wparams.abort_callback = [](void * user_data) {
+                            return ((std::atomic<bool> *) user_data)->load(std::memory_order_relaxed);
+                        };
+                        wparams.abort_callback_user_data = abort_token.get();
+
+                        if (whisper_full_with_state(model->ctx, state_guard.state, wparams,
+                                                    window.samples.data(), window.samples.size()) != 0) {
+                            failed = true;
+                            break;
+                        }
+
+                        metrics.audio_ms += window.samples.size() / (WHISPER_SAMPLE_RATE / 1000);
+
+                        const int n_window_segments = whisper_full_n_segments_from_state(state_guard.state);
+                        for (int i = 0; i < n_window_segments; i++) {
+                            const char * text = whisper_full_get_segment_text_from_state(state_guard.state, i);
+                            json segment = json{
+                                {"id", (int) segments.size()},
+                                {"text", text},
+                            };
+                            if (!params.no_timestamps) {
+                                segment["start"] = (whisper_full_get_segment_t0_from_state(state_guard.state, i) + window.t_offset_cs) * 0.01;
+                                segment["end"]   = (whisper_full_get_segment_t1_from_state(state_guard.state, i) + window.t_offset_cs) * 0.01;
+                            }
+                            segments.push_back(segment);
+                            full_text += text;
+                            full_text += "\n";
+                        }
+
+                        pcm_pool.release(std::move(window.samples));
+                    }
+                }
+
+                // on failure keep draining so the decoder is never stuck in push()
+                if (failed) {
+                    pcm_window window;
+                    while (queue.pop(window)) { }
+                }
+                decode_thread.join();
+
+                if (failed) {
+                    if (abort_token->load()) {
+                        fprintf(stderr, "[INFO] Pipeline inference cancelled by client request\n");
+                        fflush(stderr);
+                        res.status = 499; // client closed request (nginx convention)
+                        res.set_content("{\"error\":\"request cancelled\"}", "application/json");
+                        return;
+                    }
+                    fprintf(stderr, "%s: [ERROR] Failed to process audio window\n", argv[0]);
+                    fflush(stderr);
+                    metrics.inference_failures++;
+                    const std::string error_resp = "{\"error\":\"failed to process audio\"}";
+                    res.set_content(error_resp, "application/json");
+                    return;
+                }
+
+                stage_timer serialize_timer(metrics.serialize_stage_ms);
+                if (params.response_format == text_format) {
+                    if (cacheable) {
+                        response_cache.put(cache_key, full_text, "text/html; charset=utf-8");
+                    }
+                    res.set_content(full_text, "text/html; charset=utf-8");
+                } else {
+                    json jres = json{
+                        {"text", full_text},
+                        {"segments", segments}
+                    };
+                    const std::string body = jres.dump(-1, ' ', false, json::error_handler_t::replace);
+                    if (cacheable) {
+                        response_cache.put(cache_key, body, "application/json");
+                    }
+                    res.set_content(body, "application/json");
+                }
+                return;
+            }
+
+            fprintf(stderr, "[INFO] Pipeline mode needs a WAV payload (%s), using sequential path\n", pipeline_error.c_str());
+            fflush(stderr);
+        }
 
-        std::string filename{audio_file.filename};
+        std::string filename{audio_filename};
         fprintf(stderr, "[INFO] Processing file: %s\n", filename.c_str());
         fprintf(stderr, "[PARAMS] Response format: %s, Language: %s\n", 
                 params.response_format.c_str(), 
                 params.language.c_str());
         fflush(stderr);
-        // audio arrays
-        std::vector<float> pcmf32;               // mono-channel F32 PCM
+        // audio arrays, leased from the pool and sized from the upload so
+        // read_wav/decode fill them without reallocation (a 16-bit WAV has
+        // one sample per two payload bytes; other widths just over-reserve)
+        std::vector<float> pcmf32 = pcm_pool.acquire(upload.size() / sizeof(int16_t)); // mono-channel F32 PCM
         std::vector<std::vector<float>> pcmf32s; // stereo-channel F32 PCM
+        pcm_buffer_returner pcm_returner{pcm_pool, pcmf32, pcmf32s};
+
+        // Decode in process: WAV uploads at any rate/width are parsed and
+        // resampled in memory - no temp file, no fork, no disk round-trips.
+        // Only genuinely compressed uploads fall through to ffmpeg.
+        stage_timer decode_timer(metrics.decode_stage_ms);
+        std::string decode_error;
+        if (!decode_wav_in_memory(upload.data(), upload.size(), pcmf32, pcmf32s, params.diarize, decode_error)) {
+            if (!sparams.ffmpeg_converter) {
+                fprintf(stderr, "[ERROR] Failed to decode audio: %s\n", decode_error.c_str());
+                fflush(stderr);
+                metrics.inference_failures++;
+                const std::string error_resp = "{\"error\":\"failed to decode audio: " + decode_error + "\"}";
+                res.set_content(error_resp, "application/json");
+                return;
+            }
+
+            fprintf(stderr, "[INFO] In-process decode failed (%s), falling back to ffmpeg\n", decode_error.c_str());
+            fflush(stderr);
 
-        if (sparams.ffmpeg_converter) {
-            // if file is not wav, convert to wav
-            // write to temporary file
-            //const std::string temp_filename_base = std::tmpnam(nullptr);
-            const std::string temp_filename_base = "whisper-server-tmp"; // TODO: this is a hack, remove when the mutext is removed
+            // write to temporary file - name must be unique since requests run concurrently
+            static std::atomic<uint64_t> tmp_counter{0};
+            const std::string temp_filename_base = "whisper-server-tmp-" + std::to_string(tmp_counter.fetch_add(1));
             const std::string temp_filename = temp_filename_base + ".wav";
             std::ofstream temp_file{temp_filename, std::ios::binary};
-            temp_file << audio_file.content;
+            temp_file.write(upload.data(), upload.size());
             temp_file.close();
 
             std::string error_resp = "{\"error\":\"Failed to execute ffmpeg command.\"}";
@@ -738,15 +2809,69 @@ int main(int argc, char ** argv) {
             }
             // remove temp file
             std::remove(temp_filename.c_str());
-        } else {
-            if (!::read_wav(audio_file.content, pcmf32, pcmf32s, params.diarize))
-            {
-                fprintf(stderr, "[ERROR] Failed to read WAV file\n");
+        }
+        decode_timer.stop();
+        metrics.audio_ms += pcmf32.size() / (WHISPER_SAMPLE_RATE / 1000);
+
+        // VAD pre-filter (opt-in): drop non-speech regions before the encoder
+        // pays for them, keeping the span list so output timestamps can be
+        // mapped back onto the original timeline. Stereo channels are filtered
+        // identically so diarization still lines up with the mono stream.
+        const size_t n_samples_orig = pcmf32.size();
+        std::vector<vad_span> vad_spans;
+        if (params.vad) {
+            vad_spans = vad_detect_speech(pcmf32, params.vad_thold);
+
+            size_t n_kept = 0;
+            for (const auto & span : vad_spans) {
+                n_kept += span.end - span.start;
+            }
+
+            if (n_kept == 0) {
+                fprintf(stderr, "[INFO] VAD found no speech in %s\n", filename.c_str());
                 fflush(stderr);
-                const std::string error_resp = "{\"error\":\"failed to read WAV file\"}";
-                res.set_content(error_resp, "application/json");
+                if (params.response_format == json_format || params.response_format == vjson_format) {
+                    res.set_content(json{{"text", ""}}.dump(), "application/json");
+                } else {
+                    res.set_content("", "text/plain");
+                }
                 return;
             }
+
+            if (n_kept < n_samples_orig) {
+                std::vector<float> filtered = pcm_pool.acquire(n_kept);
+                std::vector<std::vector<float>> filtered_s(pcmf32s.size());
+                for (const auto & span : vad_spans) {
+                    filtered.insert(filtered.end(), pcmf32.begin() + span.start, pcmf32.begin() + span.end);
+                    for (size_t c = 0; c < pcmf32s.size(); c++) {
+                        filtered_s[c].insert(filtered_s[c].end(),
+                                             pcmf32s[c].begin() + span.start,
+                                             pcmf32s[c].begin() + span.end);
+                    }
+                }
+                pcm_pool.release(std::move(pcmf32)); // recycle the unfiltered buffer
+                pcmf32  = std::move(filtered);
+                pcmf32s = std::move(filtered_s);
+
+                fprintf(stderr, "[INFO] VAD kept %.1f%% of audio (%zu spans)\n",
+                        100.0 * n_kept / n_samples_orig, vad_spans.size());
+                fflush(stderr);
+            } else {
+                vad_spans.clear(); // everything is speech, no remapping needed
+            }
+        }
+
+        // timestamps come back on the VAD-filtered timeline; remap them onto
+        // the original recording (identity when VAD removed nothing)
+        auto map_ts = [&](int64_t t) -> int64_t {
+            return map_vad_timestamp(vad_spans, t);
+        };
+
+        // prefix sums over the (possibly VAD-filtered) stereo channels; every
+        // per-segment speaker estimate below is O(1) against this index
+        diarization_energy_index diar_energy;
+        if (params.diarize && pcmf32s.size() == 2) {
+            diar_energy.build(pcmf32s);
         }
 
         fprintf(stderr, "[INFO] Successfully loaded %s\n", filename.c_str());
@@ -756,13 +2881,13 @@ int main(int argc, char ** argv) {
         {
             fprintf(stderr, "\n");
             fprintf(stderr, "[INFO] System info: n_threads = %d / %d | %s\n",
-                    params.n_threads*params.n_processors, std::thread::hardware_concurrency(), whisper_print_system_info());
+                    params.n_threads, std::thread::hardware_concurrency(), whisper_print_system_info());
         }
 
         // print some info about the processing
         {
             fprintf(stderr, "\n");
-            if (!whisper_is_multilingual(ctx)) {
+            if (!whisper_is_multilingual(model->ctx)) {
                 if (params.language != "en" || params.translate) {
                     params.language = "en";
                     params.translate = false;
@@ -772,9 +2897,9 @@ int main(int argc, char ** argv) {
             if (params.detect_language) {
                 params.language = "auto";
             }
-            fprintf(stderr, "%s: [INFO] Processing '%s' (%d samples, %.1f sec), %d threads, %d processors, lang = %s, task = %s, %stimestamps = %d ...\n",
+            fprintf(stderr, "%s: [INFO] Processing '%s' (%d samples, %.1f sec), %d threads, lang = %s, task = %s, %stimestamps = %d ...\n",
                     __func__, filename.c_str(), int(pcmf32.size()), float(pcmf32.size())/16000,
-                    params.n_threads, params.n_processors,
+                    params.n_threads,
                     params.language.c_str(),
                     params.translate ? "translate" : "transcribe",
                     params.tinydiarize ? "tdrz = 1, " : "",
@@ -783,50 +2908,116 @@ int main(int argc, char ** argv) {
             fprintf(stderr, "\n");
         }
 
+        // check out a worker state - blocks until one is idle; a shared_ptr
+        // so the vjson streaming path can keep it alive past handler return
+        const auto t_worker_start = std::chrono::steady_clock::now();
+        auto state_guard = std::make_shared<whisper_state_guard>(model->pool);
+        queue_ms += (uint64_t) std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - t_worker_start).count();
+        struct whisper_state * state = state_guard->state;
+
+        // stream_json: decode on a background thread and push each segment
+        // to the client as an SSE event the moment it exists, instead of
+        // making a 90-minute upload wait for whisper_full to finish before
+        // the first byte goes out. Downstream summarization can start on
+        // early segments while the tail is still transcribing.
+        if (params.response_format == stream_json_format) {
+            auto job = std::make_shared<stream_json_job>();
+            job->model     = model;
+            job->guard     = state_guard;
+            job->ticket    = ticket;
+            job->params    = params;
+            job->pcmf32    = std::move(pcmf32);
+            job->vad_spans = std::move(vad_spans);
+            job->abort     = abort_token;
+
+            server_metrics * metrics_ptr = &metrics;
+
+            std::thread([job, metrics_ptr]() {
+                stage_timer inference_timer(metrics_ptr->inference_stage_ms);
+
+                whisper_full_params wparams = make_full_params(job->params);
+                wparams.new_segment_callback           = stream_json_new_segment;
+                wparams.new_segment_callback_user_data = job.get();
+
+                // stop within one encoder iteration once the client is gone
+                // or DELETE /inference/<id> flips the token, releasing the
+                // worker state and admission ticket instead of finishing a
+                // possibly 90-minute file for nobody
+                wparams.encoder_begin_callback = [](struct whisper_context * /*ctx*/, struct whisper_state * /*state*/, void * user_data) {
+                    return !((std::atomic<bool> *) user_data)->load(std::memory_order_relaxed);
+                };
+                wparams.encoder_begin_callback_user_data = job->abort.get();
+
+                wparams.abort_callback = [](void * user_data) {
+                    return ((std::atomic<bool> *) user_data)->load(std::memory_order_relaxed);
+                };
+                wparams.abort_callback_user_data = job->abort.get();
+
+                if (whisper_full_with_state(job->model->ctx, job->guard->state, wparams,
+                                            job->pcmf32.data(), job->pcmf32.size()) != 0) {
+                    if (job->abort->load()) {
+                        fprintf(stderr, "[INFO] stream_json decode abandoned, stopping\n");
+                        fflush(stderr);
+                    } else {
+                        metrics_ptr->inference_failures++;
+                        job->push_event("{\"error\":\"failed to process audio\"}");
+                    }
+                } else {
+                    job->push_event("{\"done\":true}");
+                }
+                job->finish();
+            }).detach();
+
+            res.set_header("Cache-Control", "no-cache");
+            res.set_chunked_content_provider(
+                "text/event-stream",
+                [job](size_t /*offset*/, DataSink & sink) {
+                    std::string payload;
+                    {
+                        std::unique_lock<std::mutex> lock(job->mutex);
+                        job->cv.wait_for(lock, std::chrono::seconds(15), [&] {
+                            return !job->events.empty() || job->done;
+                        });
+
+                        if (job->events.empty() && job->done) {
+                            sink.done();
+                            return true;
+                        }
+
+                        if (job->events.empty()) {
+                            // keep intermediaries from timing out the idle connection
+                            payload = ": keepalive\n\n";
+                        } else {
+                            while (!job->events.empty()) {
+                                payload += "data: " + job->events.front() + "\n\n";
+                                job->events.pop_front();
+                            }
+                        }
+                    }
+                    return sink.write(payload.data(), payload.size());
+                },
+                [job](bool success) {
+                    // provider torn down before sink.done(): the client
+                    // disconnected mid-stream, so tell the decoder to stop
+                    if (!success) {
+                        job->abort->store(true);
+                    }
+                });
+            return;
+        }
+
         // run the inference
+        uint64_t inference_ms = 0;
         {
+            stage_timer inference_timer(metrics.inference_stage_ms);
             fprintf(stderr, "[INFO] Running whisper.cpp inference on %s\n", filename.c_str());
-            whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+            whisper_full_params wparams = make_full_params(params);
 
-            wparams.strategy = params.beam_size > 1 ? WHISPER_SAMPLING_BEAM_SEARCH : WHISPER_SAMPLING_GREEDY;
+            wparams.token_timestamps = !params.no_timestamps &&
+                (params.response_format == vjson_format || params.response_format == bin_format);
 
-            wparams.print_realtime   = false;
-            wparams.print_progress   = params.print_progress;
-            wparams.print_timestamps = !params.no_timestamps;
-            wparams.print_special    = params.print_special;
-            wparams.translate        = params.translate;
-            wparams.language         = params.language.c_str();
-            wparams.n_threads        = params.n_threads;
-            wparams.n_max_text_ctx   = params.max_context >= 0 ? params.max_context : wparams.n_max_text_ctx;
-            wparams.offset_ms        = params.offset_t_ms;
-            wparams.duration_ms      = params.duration_ms;
-
-            wparams.thold_pt         = params.word_thold;
-            wparams.max_len          = params.max_len == 0 ? 60 : params.max_len;
-            wparams.split_on_word    = params.split_on_word;
-            wparams.audio_ctx        = params.audio_ctx;
-
-            wparams.debug_mode       = params.debug_mode;
-
-            wparams.tdrz_enable      = params.tinydiarize; // [TDRZ]
-
-            wparams.initial_prompt   = params.prompt.c_str();
-
-            wparams.greedy.best_of        = params.best_of;
-            wparams.beam_search.beam_size = params.beam_size;
-
-            wparams.temperature      = params.temperature;
-            wparams.no_speech_thold = params.no_speech_thold;
-            wparams.temperature_inc  = params.temperature_inc;
-            wparams.entropy_thold    = params.entropy_thold;
-            wparams.logprob_thold    = params.logprob_thold;
-
-            wparams.no_timestamps    = params.no_timestamps;
-            wparams.token_timestamps = !params.no_timestamps && params.response_format == vjson_format;
-
-            wparams.suppress_nst     = params.suppress_nst;
-
-            whisper_print_user_data user_data = { &params, &pcmf32s, 0 };
+            whisper_print_user_data user_data = { &params, &diar_energy, 0 };
 
             // this callback is called on each new segment
             if (params.print_realtime) {
@@ -839,232 +3030,602 @@ int main(int argc, char ** argv) {
                 wparams.progress_callback_user_data = &user_data;
             }
 
-            // examples for abort mechanism
-            // in examples below, we do not abort the processing, but we could if the flag is set to true
-
-            // the callback is called before every encoder run - if it returns false, the processing is aborted
-            {
-                static bool is_aborted = false; // NOTE: this should be atomic to avoid data race
-
-                wparams.encoder_begin_callback = [](struct whisper_context * /*ctx*/, struct whisper_state * /*state*/, void * user_data) {
-                    bool is_aborted = *(bool*)user_data;
-                    return !is_aborted;
-                };
-                wparams.encoder_begin_callback_user_data = &is_aborted;
-            }
-
-            // the callback is called before every computation - if it returns true, the computation is aborted
-            {
-                static bool is_aborted = false; // NOTE: this should be atomic to avoid data race
-
-                wparams.abort_callback = [](void * user_data) {
-                    bool is_aborted = *(bool*)user_data;
-                    return is_aborted;
-                };
-                wparams.abort_callback_user_data = &is_aborted;
-            }
+            // per-request cancellation: the token flips when DELETE
+            // /inference/<id> arrives; checked before every encoder pass and
+            // every computation step, so an abandoned request frees its
+            // worker within one encoder iteration
+            wparams.encoder_begin_callback = [](struct whisper_context * /*ctx*/, struct whisper_state * /*state*/, void * user_data) {
+                return !((std::atomic<bool> *) user_data)->load(std::memory_order_relaxed);
+            };
+            wparams.encoder_begin_callback_user_data = abort_token.get();
 
-            if (whisper_full_parallel(ctx, wparams, pcmf32.data(), pcmf32.size(), params.n_processors) != 0) {
+            wparams.abort_callback = [](void * user_data) {
+                return ((std::atomic<bool> *) user_data)->load(std::memory_order_relaxed);
+            };
+            wparams.abort_callback_user_data = abort_token.get();
+
+            if (whisper_full_with_state(model->ctx, state, wparams, pcmf32.data(), pcmf32.size()) != 0) {
+                if (abort_token->load()) {
+                    fprintf(stderr, "[INFO] Inference cancelled by client request\n");
+                    fflush(stderr);
+                    res.status = 499; // client closed request (nginx convention)
+                    res.set_content("{\"error\":\"request cancelled\"}", "application/json");
+                    return;
+                }
                 fprintf(stderr, "%s: [ERROR] Failed to process audio\n", argv[0]);
                 fflush(stderr);
+                metrics.inference_failures++;
                 const std::string error_resp = "{\"error\":\"failed to process audio\"}";
                 res.set_content(error_resp, "application/json");
                 return;
             }
+
+            inference_timer.stop();
+            inference_ms = inference_timer.elapsed_ms;
         }
 
+        // optional per-request timing breakdown (timing=true); whisper.cpp
+        // does not expose its internal encoder/decoder timers through the
+        // public API, so the stages are measured around our own steps instead
+        const double timing_audio_s = double(n_samples_orig) / WHISPER_SAMPLE_RATE;
+        const json timing = json{
+            {"upload_bytes",  upload.size()},
+            {"queue_ms",      queue_ms},
+            {"decode_ms",     decode_timer.elapsed_ms},
+            {"inference_ms",  inference_ms},
+            {"audio_s",       timing_audio_s},
+            {"rtf",           timing_audio_s > 0.0 ? (inference_ms / 1000.0) / timing_audio_s : 0.0},
+        };
+
         // return results to user
+        stage_timer serialize_timer(metrics.serialize_stage_ms);
         if (params.response_format == text_format)
         {
-            std::string results = output_str(ctx, params, pcmf32s);
+            std::string results = output_str(state, params, diar_energy);
+            if (cacheable) {
+                response_cache.put(cache_key, results, "text/html; charset=utf-8");
+            }
             res.set_content(results.c_str(), "text/html; charset=utf-8");
         }
         else if (params.response_format == srt_format)
         {
             std::stringstream ss;
-            const int n_segments = whisper_full_n_segments(ctx);
+            const int n_segments = whisper_full_n_segments_from_state(state);
             for (int i = 0; i < n_segments; ++i) {
-                const char * text = whisper_full_get_segment_text(ctx, i);
-                const int64_t t0 = whisper_full_get_segment_t0(ctx, i);
-                const int64_t t1 = whisper_full_get_segment_t1(ctx, i);
+                const char * text = whisper_full_get_segment_text_from_state(state, i);
+                const int64_t t0 = whisper_full_get_segment_t0_from_state(state, i);
+                const int64_t t1 = whisper_full_get_segment_t1_from_state(state, i);
                 
                 std::string speaker = "";
 
-                if (params.diarize && pcmf32s.size() == 2)
+                if (params.diarize && diar_energy.ready())
                 {
-                    speaker = estimate_diarization_speaker(pcmf32s, t0, t1);
+                    speaker = estimate_diarization_speaker(diar_energy, t0, t1);
                 }
 
                 ss << i + 1 + params.offset_n << "\n";
-                ss << to_timestamp(t0, true) << " --> " << to_timestamp(t1, true) << "\n";
+                ss << to_timestamp(map_ts(t0), true) << " --> " << to_timestamp(map_ts(t1), true) << "\n";
                 ss << speaker << text << "\n\n";
             }
+            if (cacheable) {
+                response_cache.put(cache_key, ss.str(), "application/x-subrip");
+            }
             res.set_content(ss.str(), "application/x-subrip");
         } else if (params.response_format == vtt_format) {
             std::stringstream ss;
 
             ss << "WEBVTT\n\n";
 
-            const int n_segments = whisper_full_n_segments(ctx);
+            const int n_segments = whisper_full_n_segments_from_state(state);
             for (int i = 0; i < n_segments; ++i) {
-                const char * text = whisper_full_get_segment_text(ctx, i);
-                const int64_t t0 = whisper_full_get_segment_t0(ctx, i);
-                const int64_t t1 = whisper_full_get_segment_t1(ctx, i);
+                const char * text = whisper_full_get_segment_text_from_state(state, i);
+                const int64_t t0 = whisper_full_get_segment_t0_from_state(state, i);
+                const int64_t t1 = whisper_full_get_segment_t1_from_state(state, i);
                 
                 std::string speaker = "";
 
-                if (params.diarize && pcmf32s.size() == 2)
+                if (params.diarize && diar_energy.ready())
                 {
-                    speaker = estimate_diarization_speaker(pcmf32s, t0, t1, true);
+                    speaker = estimate_diarization_speaker(diar_energy, t0, t1, true);
                     speaker.insert(0, "<v Speaker");
                     speaker.append(">");
                 }
 
-                ss << to_timestamp(t0) << " --> " << to_timestamp(t1) << "\n";
+                ss << to_timestamp(map_ts(t0)) << " --> " << to_timestamp(map_ts(t1)) << "\n";
                 ss << speaker << text << "\n\n";
             }
+            if (cacheable) {
+                response_cache.put(cache_key, ss.str(), "text/vtt");
+            }
             res.set_content(ss.str(), "text/vtt");
         } else if (params.response_format == vjson_format) {
             /* try to match openai/whisper's Python format */
-            std::string results = output_str(ctx, params, pcmf32s);
-            json jres = json{
+            // Chunked-transfer streaming instead of one giant json + dump():
+            // the header goes out immediately and each segment is serialized
+            // straight into the socket, so peak memory stays flat and
+            // time-to-first-byte does not depend on the meeting length. The
+            // streamer pins the worker state until the response completes.
+            std::string results = output_str(state, params, diar_energy);
+            json header = json{
                 {"task", params.translate ? "translate" : "transcribe"},
-                {"language", whisper_lang_str_full(whisper_full_lang_id(ctx))},
-                {"duration", float(pcmf32.size())/16000},
+                {"language", whisper_lang_str_full(whisper_full_lang_id_from_state(state))},
+                {"duration", float(n_samples_orig)/16000},
                 {"text", results},
-                {"segments", json::array()}
             };
-            const int n_segments = whisper_full_n_segments(ctx);
-            for (int i = 0; i < n_segments; ++i)
-            {
-                json segment = json{
-                    {"id", i},
-                    {"text", whisper_full_get_segment_text(ctx, i)},
-                };
+            if (params.timing) {
+                header["timing"] = timing;
+            }
+            std::string head = header.dump(-1, ' ', false, json::error_handler_t::replace);
+            head.pop_back();           // re-open the object ...
+            head += ",\"segments\":["; // ... segments are appended per chunk
+
+            auto streamer = std::make_shared<vjson_streamer>();
+            streamer->model      = model;
+            streamer->guard      = state_guard;
+            streamer->params     = params;
+            streamer->vad_spans  = std::move(vad_spans);
+            streamer->head       = std::move(head);
+            streamer->n_segments = whisper_full_n_segments_from_state(state);
+
+            serialize_timer.stop();
+            server_metrics * metrics_ptr = &metrics;
+
+            res.set_chunked_content_provider(
+                "application/json",
+                [streamer, metrics_ptr](size_t /*offset*/, DataSink & sink) {
+                    stage_timer serialize_timer(metrics_ptr->serialize_stage_ms);
+
+                    std::string chunk;
+                    if (streamer->next == 0) {
+                        chunk = std::move(streamer->head);
+                    } else if (streamer->next <= streamer->n_segments) {
+                        const int i = streamer->next - 1;
+                        if (i > 0) {
+                            chunk = ",";
+                        }
+                        chunk += vjson_segment(streamer->model->ctx, streamer->guard->state,
+                                               streamer->params, streamer->vad_spans, i)
+                                     .dump(-1, ' ', false, json::error_handler_t::replace);
+                    } else {
+                        chunk = "]}";
+                    }
 
-                if (!params.no_timestamps) {
-                    segment["start"] = whisper_full_get_segment_t0(ctx, i) * 0.01;
-                    segment["end"] = whisper_full_get_segment_t1(ctx, i) * 0.01;
-                }
+                    const bool last = streamer->next > streamer->n_segments;
+                    streamer->next++;
 
-                float total_logprob = 0;
-                const int n_tokens = whisper_full_n_tokens(ctx, i);
-                for (int j = 0; j < n_tokens; ++j) {
-                    whisper_token_data token = whisper_full_get_token_data(ctx, i, j);
-                    if (token.id >= whisper_token_eot(ctx)) {
-                        continue;
+                    if (!sink.write(chunk.data(), chunk.size())) {
+                        return false;
                     }
-
-                    segment["tokens"].push_back(token.id);
-                    json word = json{{"word", whisper_full_get_token_text(ctx, i, j)}};
-                    if (!params.no_timestamps) {
-                        word["start"] = token.t0 * 0.01;
-                        word["end"] = token.t1 * 0.01;
-                        word["t_dtw"] = token.t_dtw;
+                    if (last) {
+                        sink.done();
                     }
-                    word["probability"] = token.p;
-                    total_logprob += token.plog;
-                    segment["words"].push_back(word);
-                }
-
-                segment["temperature"] = params.temperature;
-                segment["avg_logprob"] = total_logprob / n_tokens;
-
-                // TODO compression_ratio and no_speech_prob are not implemented yet
-                // segment["compression_ratio"] = 0;
-                segment["no_speech_prob"] = whisper_full_get_segment_no_speech_prob(ctx, i);
-
-                jres["segments"].push_back(segment);
+                    return true;
+                });
+        } else if (params.response_format == bin_format) {
+            std::string blob = output_binary(model->ctx, state, vad_spans);
+            if (cacheable) {
+                response_cache.put(cache_key, blob, "application/octet-stream");
             }
-            res.set_content(jres.dump(-1, ' ', false, json::error_handler_t::replace),
-                            "application/json");
+            res.set_content(blob, "application/octet-stream");
         }
         // TODO add more output formats
         else
         {
-            std::string results = output_str(ctx, params, pcmf32s);
+            std::string results = output_str(state, params, diar_energy);
             json jres = json{
                 {"text", results}
             };
-            res.set_content(jres.dump(-1, ' ', false, json::error_handler_t::replace),
-                            "application/json");
+            if (params.timing) {
+                jres["timing"] = timing;
+            }
+            const std::string body = jres.dump(-1, ' ', false, json::error_handler_t::replace);
+            if (cacheable) {
+                response_cache.put(cache_key, body, "application/json");
+            }
+            res.set_content(body, "application/json");
         }
+    });
 
-        // reset params to their defaults
-        params = default_params;
+    // Cancel an in-flight inference by the request_id it was submitted with.
+    // The abort token is checked from whisper's callbacks, so the worker
+    // stops at the next encoder pass rather than finishing the whole file.
+    svr.Delete(sparams.request_path + "/inference/:id", [&](const Request &req, Response &res) {
+        const std::string id = req.path_params.at("id");
+        if (inflight.cancel(id)) {
+            fprintf(stderr, "[INFO] Cancellation requested for inference '%s'\n", id.c_str());
+            fflush(stderr);
+            res.set_content("{\"status\":\"cancelling\"}", "application/json");
+        } else {
+            res.status = 404;
+            res.set_content("{\"error\":\"no in-flight inference with that request_id\"}", "application/json");
+        }
     });
 
-    // Add audio buffer management
-    const int MIN_AUDIO_LENGTH_MS = 1000;  // minimum 1 second of audio
-    std::vector<float> audio_buffer;
+    // Streaming session management
+    stream_session_store stream_sessions;
 
-    // Add streaming endpoint
+    // Add streaming endpoint - sessions are keyed by a client-supplied "session_id"
+    // field so concurrent meetings each get their own buffer and decode state
     svr.Post(sparams.request_path + "/stream", [&](const Request &req, Response &res) {
-        // acquire whisper model mutex lock
-        std::lock_guard<std::mutex> lock(whisper_mutex);
-
         if (!req.has_file("audio")) {
             res.set_content("{\"error\":\"no audio data\"}", "application/json");
             return;
         }
 
+        // older clients that never send a session ID all share one session,
+        // which matches the previous single-buffer behavior
+        const std::string session_id = req.has_file("session_id")
+            ? req.get_file_value("session_id").content
+            : "default";
+
+        stream_sessions.evict_idle(sparams.stream_idle_timeout);
+
+        // allow clients to tear down their session explicitly at meeting end
+        if (req.has_file("final") && parse_str_to_bool(req.get_file_value("final").content)) {
+            stream_sessions.remove(session_id);
+            res.set_content("{\"status\":\"session closed\"}", "application/json");
+            return;
+        }
+
+        // sessions stay on the model they started with; new sessions take the
+        // request's "model" field or fall back to the current default
+        std::string model_path;
+        if (req.has_file("model")) {
+            model_path = req.get_file_value("model").content;
+        } else {
+            std::lock_guard<std::mutex> lock(whisper_mutex);
+            model_path = default_params.model;
+        }
+
+        std::string model_error;
+        auto model = models.get(model_path, model_error);
+        if (model == nullptr) {
+            res.status = 400;
+            res.set_content("{\"error\":\"" + model_error + "\"}", "application/json");
+            return;
+        }
+
+        auto session = stream_sessions.get_or_create(session_id, model);
+        if (session == nullptr) {
+            res.set_content("{\"error\":\"failed to initialize stream session\"}", "application/json");
+            return;
+        }
+
+        // serialize chunks within this session only - other sessions proceed in parallel
+        std::lock_guard<std::mutex> lock(session->mutex);
+        session->last_active = std::chrono::steady_clock::now();
+
+        if (req.has_file("incremental")) {
+            session->incremental = parse_str_to_bool(req.get_file_value("incremental").content);
+        }
+
+        metrics.stream_requests++;
+
         auto audio_file = req.get_file_value("audio");
         const float* audio_data = reinterpret_cast<const float*>(audio_file.content.c_str());
         int n_samples = audio_file.content.size() / sizeof(float);
 
         // Add new samples to buffer
+        auto & audio_buffer = session->audio_buffer;
         audio_buffer.insert(audio_buffer.end(), audio_data, audio_data + n_samples);
+        metrics.audio_ms += (uint64_t) n_samples / (WHISPER_SAMPLE_RATE / 1000);
 
-        // Calculate minimum required samples
-        const int min_samples = (MIN_AUDIO_LENGTH_MS * 16000) / 1000;
+        // live chunks take priority over batch uploads in the admission queue
+        admission_ticket ticket(admission, /*high_priority*/ true);
+        if (!ticket.admitted) {
+            send_queue_full(res, admission);
+            return;
+        }
 
-        json response;
-        response["segments"] = json::array();
+        json response = run_stream_decode(*session, params, session_id);
+        if (response.contains("error")) {
+            metrics.stream_failures++;
+        }
+        res.set_content(response.dump(), "application/json");
+    });
 
-        // Only process if we have enough audio data
-        if (audio_buffer.size() >= min_samples) {
-            // Run inference
-            whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-            wparams.print_progress = false;
-            wparams.print_special = params.print_special;
-            wparams.language = params.language.c_str();
-            wparams.n_threads = params.n_threads;
-            
-            if (whisper_full(ctx, wparams, audio_buffer.data(), audio_buffer.size()) != 0) {
-                res.set_content("{\"error\":\"failed to process audio\"}", "application/json");
-                return;
-            }
+    // Raw PCM ingest: application/octet-stream chunks are streamed by httplib's
+    // content receiver straight into the session buffer, skipping the multipart
+    // parse and the get_file_value copy entirely. Format is declared up front:
+    //   X-Sample-Format: f32 (default) or s16, little-endian
+    //   X-Sample-Rate:   must be 16000
+    // Session ID and options come from query params since there is no form body.
+    svr.Post(sparams.request_path + "/stream/pcm", [&](const Request &req, Response &res, const ContentReader &content_reader) {
+        const std::string session_id = req.has_param("session_id")
+            ? req.get_param_value("session_id")
+            : "default";
+
+        const std::string format = req.has_header("X-Sample-Format")
+            ? req.get_header_value("X-Sample-Format")
+            : "f32";
+        if (format != "f32" && format != "s16") {
+            res.status = 400;
+            res.set_content("{\"error\":\"unsupported X-Sample-Format, expected f32 or s16\"}", "application/json");
+            return;
+        }
 
-            // Get transcription
-            const int n_segments = whisper_full_n_segments(ctx);
-            
-            for (int i = 0; i < n_segments; ++i) {
-                const char* text = whisper_full_get_segment_text(ctx, i);
-                const int64_t t0 = whisper_full_get_segment_t0(ctx, i);
-                const int64_t t1 = whisper_full_get_segment_t1(ctx, i);
-                
-                json segment;
-                segment["text"] = text;
-                segment["t0"] = t0;
-                segment["t1"] = t1;
-                response["segments"].push_back(segment);
-            }
+        if (req.has_header("X-Sample-Rate") &&
+            req.get_header_value("X-Sample-Rate") != std::to_string(WHISPER_SAMPLE_RATE)) {
+            res.status = 400;
+            res.set_content("{\"error\":\"unsupported X-Sample-Rate, expected 16000\"}", "application/json");
+            return;
+        }
+
+        stream_sessions.evict_idle(sparams.stream_idle_timeout);
+
+        // no form body here, so model selection rides on a query param
+        std::string model_path;
+        if (req.has_param("model")) {
+            model_path = req.get_param_value("model");
+        } else {
+            std::lock_guard<std::mutex> lock(whisper_mutex);
+            model_path = default_params.model;
+        }
+
+        std::string model_error;
+        auto model = models.get(model_path, model_error);
+        if (model == nullptr) {
+            res.status = 400;
+            res.set_content("{\"error\":\"" + model_error + "\"}", "application/json");
+            return;
+        }
+
+        auto session = stream_sessions.get_or_create(session_id, model);
+        if (session == nullptr) {
+            res.set_content("{\"error\":\"failed to initialize stream session\"}", "application/json");
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(session->mutex);
+        session->last_active = std::chrono::steady_clock::now();
+
+        if (req.has_param("incremental")) {
+            session->incremental = parse_str_to_bool(req.get_param_value("incremental"));
+        }
+
+        // pre-size the buffer from Content-Length so the receiver never reallocates
+        auto & audio_buffer = session->audio_buffer;
+        if (req.has_header("Content-Length")) {
+            const size_t content_length = std::stoull(req.get_header_value("Content-Length"));
+            const size_t sample_size = format == "f32" ? sizeof(float) : sizeof(int16_t);
+            audio_buffer.reserve(audio_buffer.size() + content_length / sample_size);
+        }
+
+        metrics.stream_requests++;
+        const size_t n_buffered_before = audio_buffer.size();
 
-            // Keep a small overlap for context
-            const int overlap_samples = (200 * 16000) / 1000; // 200ms overlap
-            if (audio_buffer.size() > overlap_samples) {
-                audio_buffer.erase(audio_buffer.begin(), audio_buffer.end() - overlap_samples);
+        // a sample may straddle two receiver chunks; carry its leading bytes over
+        uint8_t carry[sizeof(float)];
+        size_t n_carry = 0;
+        const size_t sample_size = format == "f32" ? sizeof(float) : sizeof(int16_t);
+        const bool is_f32 = format == "f32";
+
+        auto append_samples = [&](const uint8_t * bytes, size_t n_samples_in) {
+            if (is_f32) {
+                const float * f = reinterpret_cast<const float *>(bytes);
+                audio_buffer.insert(audio_buffer.end(), f, f + n_samples_in);
             } else {
-                audio_buffer.clear();
+                const int16_t * s = reinterpret_cast<const int16_t *>(bytes);
+                for (size_t i = 0; i < n_samples_in; i++) {
+                    audio_buffer.push_back(float(s[i]) / 32768.0f);
+                }
+            }
+        };
+
+        content_reader([&](const char * data, size_t data_length) {
+            const uint8_t * p = reinterpret_cast<const uint8_t *>(data);
+            size_t remaining = data_length;
+
+            if (n_carry > 0) {
+                const size_t need = sample_size - n_carry;
+                const size_t take = remaining < need ? remaining : need;
+                memcpy(carry + n_carry, p, take);
+                n_carry += take;
+                p += take;
+                remaining -= take;
+                if (n_carry == sample_size) {
+                    append_samples(carry, 1);
+                    n_carry = 0;
+                }
             }
+
+            const size_t n_whole = remaining / sample_size;
+            append_samples(p, n_whole);
+
+            const size_t tail = remaining - n_whole * sample_size;
+            if (tail > 0) {
+                memcpy(carry, p + n_whole * sample_size, tail);
+                n_carry = tail;
+            }
+            return true;
+        });
+
+        if (n_carry > 0) {
+            fprintf(stderr, "[WARNING] /stream/pcm body for session '%s' ended mid-sample (%zu trailing bytes dropped)\n",
+                    session_id.c_str(), n_carry);
+            fflush(stderr);
         }
 
-        response["buffer_size_ms"] = (audio_buffer.size() * 1000) / 16000;
+        metrics.audio_ms += (audio_buffer.size() - n_buffered_before) / (WHISPER_SAMPLE_RATE / 1000);
+
+        // live chunks take priority over batch uploads in the admission queue
+        admission_ticket ticket(admission, /*high_priority*/ true);
+        if (!ticket.admitted) {
+            send_queue_full(res, admission);
+            return;
+        }
+
+        json response = run_stream_decode(*session, params, session_id);
+        if (response.contains("error")) {
+            metrics.stream_failures++;
+        }
         res.set_content(response.dump(), "application/json");
     });
 
+    // Readiness for orchestration: 200 only once the default model is loaded
+    // and has completed its warm-up pass, so traffic is routed here only when
+    // steady-state latency is available.
+    svr.Get(sparams.request_path + "/health", [&](const Request &, Response &res) {
+        std::string model_path;
+        {
+            std::lock_guard<std::mutex> lock(whisper_mutex);
+            model_path = default_params.model;
+        }
+
+        auto entry = models.peek(model_path);
+        const bool loaded = entry != nullptr;
+        const bool warmed = loaded && entry->warmed.load();
+
+        json health = json{
+            {"status", loaded && warmed ? "ok" : "starting"},
+            {"model", model_path},
+            {"model_loaded", loaded},
+            {"warmed_up", warmed},
+        };
+
+        res.status = loaded && warmed ? 200 : 503;
+        res.set_content(health.dump(), "application/json");
+    });
+
+    // Prometheus-format operational metrics. Counters are plain atomics bumped
+    // on the hot path; rendering only happens here, at scrape time.
+    svr.Get(sparams.request_path + "/metrics", [&](const Request &, Response &res) {
+        const uint64_t inference_requests = metrics.inference_requests.load();
+        const uint64_t inference_failures = metrics.inference_failures.load();
+        const uint64_t stream_requests    = metrics.stream_requests.load();
+        const uint64_t stream_failures    = metrics.stream_failures.load();
+        const uint64_t audio_ms           = metrics.audio_ms.load();
+        const uint64_t decode_ms          = metrics.decode_stage_ms.load();
+        const uint64_t inference_ms       = metrics.inference_stage_ms.load();
+        const uint64_t serialize_ms       = metrics.serialize_stage_ms.load();
+
+        // aggregate real-time factor: wall time spent in whisper_full per
+        // second of audio transcribed (lower is faster)
+        const double rtf = audio_ms > 0 ? (double) inference_ms / (double) audio_ms : 0.0;
+
+        std::stringstream ss;
+        ss << "# HELP whisper_server_requests_total Requests received per endpoint\n";
+        ss << "# TYPE whisper_server_requests_total counter\n";
+        ss << "whisper_server_requests_total{endpoint=\"inference\"} " << inference_requests << "\n";
+        ss << "whisper_server_requests_total{endpoint=\"stream\"} " << stream_requests << "\n";
+        ss << "# HELP whisper_server_failures_total Failed requests per endpoint\n";
+        ss << "# TYPE whisper_server_failures_total counter\n";
+        ss << "whisper_server_failures_total{endpoint=\"inference\"} " << inference_failures << "\n";
+        ss << "whisper_server_failures_total{endpoint=\"stream\"} " << stream_failures << "\n";
+        ss << "# HELP whisper_server_cache_requests_total Response cache lookups by result\n";
+        ss << "# TYPE whisper_server_cache_requests_total counter\n";
+        ss << "whisper_server_cache_requests_total{result=\"hit\"} " << response_cache.hits.load() << "\n";
+        ss << "whisper_server_cache_requests_total{result=\"miss\"} " << response_cache.misses.load() << "\n";
+        ss << "# HELP whisper_server_rejected_total Requests rejected by the admission queue\n";
+        ss << "# TYPE whisper_server_rejected_total counter\n";
+        ss << "whisper_server_rejected_total " << admission.n_rejected.load() << "\n";
+        ss << "# HELP whisper_server_audio_seconds_total Seconds of audio transcribed\n";
+        ss << "# TYPE whisper_server_audio_seconds_total counter\n";
+        ss << "whisper_server_audio_seconds_total " << audio_ms / 1000.0 << "\n";
+        ss << "# HELP whisper_server_stage_seconds_total Wall time per processing stage\n";
+        ss << "# TYPE whisper_server_stage_seconds_total counter\n";
+        ss << "whisper_server_stage_seconds_total{stage=\"decode\"} " << decode_ms / 1000.0 << "\n";
+        ss << "whisper_server_stage_seconds_total{stage=\"inference\"} " << inference_ms / 1000.0 << "\n";
+        ss << "whisper_server_stage_seconds_total{stage=\"serialize\"} " << serialize_ms / 1000.0 << "\n";
+        std::string default_model;
+        {
+            std::lock_guard<std::mutex> lock(whisper_mutex);
+            default_model = default_params.model;
+        }
+
+        ss << "# HELP whisper_server_rtf Aggregate real-time factor (inference wall time / audio time)\n";
+        ss << "# TYPE whisper_server_rtf gauge\n";
+        ss << "whisper_server_rtf{model=\"" << default_model << "\"} " << rtf << "\n";
+        ss << "# HELP whisper_server_queue_depth Requests waiting for a worker\n";
+        ss << "# TYPE whisper_server_queue_depth gauge\n";
+        ss << "whisper_server_queue_depth " << admission.depth() << "\n";
+        ss << "# HELP whisper_server_active_decodes Decodes currently running\n";
+        ss << "# TYPE whisper_server_active_decodes gauge\n";
+        ss << "whisper_server_active_decodes " << admission.active_now() << "\n";
+        ss << "# HELP whisper_server_stream_sessions Live streaming sessions\n";
+        ss << "# TYPE whisper_server_stream_sessions gauge\n";
+        ss << "whisper_server_stream_sessions " << stream_sessions.size() << "\n";
+
+        res.set_content(ss.str(), "text/plain; version=0.0.4");
+    });
+
+    // Persistent SSE event stream for a session. Clients keep this connection
+    // open and receive each segment as a 'data:' event the moment the POST
+    // /stream decode produces it, instead of paying multipart+JSON round-trip
+    // overhead for every poll. (httplib has no WebSocket support, so SSE is
+    // the push transport here.)
+    svr.Get(sparams.request_path + "/stream/events", [&](const Request &req, Response &res) {
+        const std::string session_id = req.has_param("session_id")
+            ? req.get_param_value("session_id")
+            : "default";
+
+        std::string model_path;
+        if (req.has_param("model")) {
+            model_path = req.get_param_value("model");
+        } else {
+            std::lock_guard<std::mutex> lock(whisper_mutex);
+            model_path = default_params.model;
+        }
+
+        std::string model_error;
+        auto model = models.get(model_path, model_error);
+        if (model == nullptr) {
+            res.status = 400;
+            res.set_content("{\"error\":\"" + model_error + "\"}", "application/json");
+            return;
+        }
+
+        auto session = stream_sessions.get_or_create(session_id, model);
+        if (session == nullptr) {
+            res.status = 500;
+            res.set_content("{\"error\":\"failed to initialize stream session\"}", "application/json");
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(session->events_mutex);
+            session->subscribers++;
+        }
+
+        res.set_header("Cache-Control", "no-cache");
+        res.set_chunked_content_provider(
+            "text/event-stream",
+            [session](size_t /*offset*/, DataSink & sink) {
+                std::string payload;
+                {
+                    std::unique_lock<std::mutex> lock(session->events_mutex);
+                    session->events_cv.wait_for(lock, std::chrono::seconds(15), [&] {
+                        return !session->events.empty() || session->closed;
+                    });
+
+                    if (session->closed && session->events.empty()) {
+                        sink.done();
+                        return true;
+                    }
+
+                    if (session->events.empty()) {
+                        // keep intermediaries from timing out the idle connection
+                        payload = ": keepalive\n\n";
+                    } else {
+                        while (!session->events.empty()) {
+                            payload += "data: " + session->events.front() + "\n\n";
+                            session->events.pop_front();
+                        }
+                    }
+                }
+                return sink.write(payload.data(), payload.size());
+            },
+            [session](bool /*success*/) {
+                // connection gone: stop queueing events for it, and drop
+                // anything it never drained
+                std::lock_guard<std::mutex> lock(session->events_mutex);
+                if (--session->subscribers == 0) {
+                    session->events.clear();
+                }
+            });
+    });
+
     svr.Post(sparams.request_path + "/load", [&](const Request &req, Response &res){
-        std::lock_guard<std::mutex> lock(whisper_mutex);
         if (!req.has_file("model"))
         {
             fprintf(stderr, "[ERROR] No 'model' field in the request\n");
@@ -1074,35 +3635,38 @@ int main(int argc, char ** argv) {
             return;
         }
         std::string model = req.get_file_value("model").content;
-        if (!is_file_exist(model.c_str()))
-        {
-            fprintf(stderr, "[ERROR] 'model': %s not found!\n", model.c_str());
+
+        // warm the cache first - a bad model path leaves the current default
+        // serving traffic instead of taking the server down
+        std::string model_error;
+        auto entry = models.get(model, model_error);
+        if (entry == nullptr) {
+            fprintf(stderr, "[ERROR] %s\n", model_error.c_str());
             fflush(stderr);
-            const std::string error_resp = "{\"error\":\"model not found!\"}";
+            const std::string error_resp = "{\"error\":\"" + model_error + "\"}";
             res.set_content(error_resp, "application/json");
             return;
         }
 
-        // clean up
-        whisper_free(ctx);
-
-        // whisper init
-        ctx = whisper_init_from_file_with_params(model.c_str(), cparams);
+        // and run the warm-up pass so the switch doesn't stall live captions
+        for (const auto & shard : models.shards_of(model)) {
+            if (!shard->warmed) {
+                warm_up_model(shard, params.n_threads);
+            }
+        }
 
-        // TODO perhaps load prior model here instead of exit
-        if (ctx == nullptr) {
-            fprintf(stderr, "[ERROR] Model init failed, no model loaded must exit\n");
-            fflush(stderr);
-            exit(1);
+        // switch the default for future requests; in-flight requests and live
+        // streaming sessions keep their entry pinned until they finish
+        {
+            std::lock_guard<std::mutex> lock(whisper_mutex);
+            default_params.model = model;
         }
 
-        // initialize openvino encoder. this has no effect on whisper.cpp builds that don't have OpenVINO configured
-        whisper_ctx_init_openvino_encoder(ctx, nullptr, params.openvino_encode_device.c_str(), nullptr);
+        fprintf(stderr, "[INFO] Default model switched to '%s'\n", model.c_str());
+        fflush(stderr);
 
         const std::string success = "Load was successful!";
         res.set_content(success, "application/text");
-
-        // check if the model is in the file system
     });
 
     svr.set_exception_handler([](const Request &, Response &res, std::exception_ptr ep) {
@@ -1154,6 +3718,7 @@ int main(int argc, char ** argv) {
     fprintf(stderr, "- Inference path: %s\n", sparams.inference_path.c_str());
     fprintf(stderr, "- Request path: %s\n", sparams.request_path.c_str());
     fprintf(stderr, "- Threads: %d\n", params.n_threads);
+    fprintf(stderr, "- Workers: %d\n", sparams.n_workers);
     fprintf(stderr, "- Read timeout: %d seconds\n", sparams.read_timeout);
     fprintf(stderr, "- Write timeout: %d seconds\n", sparams.write_timeout);
     fflush(stderr);
@@ -1163,8 +3728,7 @@ int main(int argc, char ** argv) {
         return 1;
     }
 
-    whisper_print_timings(ctx);
-    whisper_free(ctx);
+    // cached model entries free their contexts as the cache goes out of scope
 
     return 0;
 }
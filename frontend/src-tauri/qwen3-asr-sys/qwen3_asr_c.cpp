@@ -5,10 +5,19 @@
 
 #include "qwen3_asr_c.h"
 
+#include <atomic>
 #include <cstring>
 #include <cstdlib>
 #include <string>
 #include <chrono>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #ifdef QWEN3_ASR_HAS_VENDOR
 #include "qwen3_asr.h"
@@ -27,8 +36,160 @@ struct qwen3_asr_context {
     Qwen3ASRModel* model;
 #endif
     bool model_loaded;
+    std::string model_path;  // path of the currently loaded model, for reload
+
+    // set by qwen3_asr_cancel from any thread, polled between decode
+    // windows, cleared when a new top-level transcription starts
+    std::atomic<bool> cancel_requested;
+
+    // read-only mapping of the GGUF file, held for the model's lifetime so
+    // weight pages stay shared in the page cache across reloads
+    void* map_addr;
+    size_t map_size;
+};
+
+// Map the GGUF read-only and kick off readahead, so the file is paging in
+// while the loader parses it and second launches come straight from the page
+// cache. Purely advisory: load proceeds unmapped if the mapping fails.
+static void map_model_file(qwen3_asr_context* ctx, const char* model_path) {
+#ifndef _WIN32
+    int fd = open(model_path, O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return;
+    }
+
+    void* addr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);  // the mapping keeps its own reference
+    if (addr == MAP_FAILED) return;
+
+    madvise(addr, (size_t)st.st_size, MADV_WILLNEED);
+
+    ctx->map_addr = addr;
+    ctx->map_size = (size_t)st.st_size;
+#else
+    // Windows relies on the system file cache; no mapping kept
+    (void)ctx;
+    (void)model_path;
+#endif
+}
+
+static void unmap_model_file(qwen3_asr_context* ctx) {
+#ifndef _WIN32
+    if (ctx->map_addr) {
+        munmap(ctx->map_addr, ctx->map_size);
+    }
+#endif
+    ctx->map_addr = nullptr;
+    ctx->map_size = 0;
+}
+
+// Arena behind qwen3_asr_result_view: owns the transcript and token strings
+// (moved straight out of the vendor result, never copied) plus the pointer
+// table handed to the caller. One delete releases everything.
+struct qwen3_asr_result_handle {
+    std::string text;
+    std::vector<std::string> tokens;
+    std::vector<const char*> token_ptrs;
+};
+
+// A streaming session buffers fed audio and decodes it window by window, so
+// every feed pays only for the audio it delivered - never for the whole
+// session so far. Text and token counts accumulate across windows.
+struct qwen3_asr_stream {
+    qwen3_asr_context* ctx;
+    struct qwen3_asr_params params;
+    std::vector<float> pending;  // audio fed but not yet decoded
+    std::string text;            // transcript accumulated so far
+    int32_t n_tokens;
+    float decode_ms;             // total time spent decoding windows
+    bool aborted;                // callback returned false
+    bool failed;                 // a window decode failed
+};
+
+// samples per decode window (5s at 16kHz) - bounds both the latency of a
+// partial caption and the marginal cost of one feed
+static const int32_t QWEN3_ASR_STREAM_WINDOW = 5 * 16000;
+
+// Fixed-size slab of contexts with one atomic busy flag per slot; checkout
+// is a CAS scan, so worker threads never contend on a mutex.
+struct qwen3_asr_pool {
+    qwen3_asr_context** contexts;
+    std::atomic<bool>* in_use;
+    int32_t n_contexts;
 };
 
+// Decode one window of session audio, appending tokens to the session
+// transcript and forwarding them to the callback. Sets stream->aborted or
+// stream->failed as appropriate.
+static void stream_decode_window(
+    qwen3_asr_stream* stream,
+    const float* data,
+    int32_t count,
+    qwen3_asr_token_callback callback,
+    void* user_data
+) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+#ifdef QWEN3_ASR_HAS_VENDOR
+    qwen3_asr::transcribe_params tp;
+    tp.n_threads = stream->params.n_threads > 0 ? stream->params.n_threads : 4;
+    tp.print_progress = false;
+    tp.print_timing = false;
+
+    auto res = stream->ctx->model->transcribe(data, count, tp);
+    if (!res.success) {
+        stream->failed = true;
+        return;
+    }
+
+    for (const auto& token : res.tokens) {
+        if (callback && !callback(token.c_str(), user_data)) {
+            stream->aborted = true;
+            return;
+        }
+        stream->text += token;
+        stream->n_tokens++;
+    }
+#else
+    // Stub: one placeholder token per window
+    (void)data;
+    std::string token = "[Qwen3-ASR stream window: " + std::to_string(count) + " samples]";
+    if (callback && !callback(token.c_str(), user_data)) {
+        stream->aborted = true;
+        return;
+    }
+    stream->text += token;
+    stream->n_tokens++;
+#endif
+
+    auto end = std::chrono::high_resolution_clock::now();
+    stream->decode_ms += std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+// True when the current decode should stop early: either qwen3_asr_cancel
+// was called on the context, or the per-call max_decode_ms deadline passed.
+static bool decode_should_stop(
+    const qwen3_asr_context* ctx,
+    const struct qwen3_asr_params& params,
+    std::chrono::high_resolution_clock::time_point start
+) {
+    if (ctx->cancel_requested.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    if (params.max_decode_ms > 0) {
+        float elapsed = std::chrono::duration<float, std::milli>(
+            std::chrono::high_resolution_clock::now() - start).count();
+        if (elapsed >= (float)params.max_decode_ms) {
+            return true;
+        }
+    }
+    return false;
+}
+
 static char* strdup_safe(const std::string& s) {
     char* out = (char*)malloc(s.size() + 1);
     if (out) {
@@ -45,6 +206,7 @@ struct qwen3_asr_params qwen3_asr_default_params(void) {
     params.use_gpu = true;
     params.gpu_device = 0;
     params.temperature = 0.0f;  // greedy decoding
+    params.max_decode_ms = 0;   // no deadline
     return params;
 }
 
@@ -52,12 +214,19 @@ qwen3_asr_context* qwen3_asr_init(void) {
     auto* ctx = new qwen3_asr_context();
     ctx->model = nullptr;
     ctx->model_loaded = false;
+    ctx->map_addr = nullptr;
+    ctx->map_size = 0;
+    ctx->cancel_requested.store(false, std::memory_order_relaxed);
     return ctx;
 }
 
 bool qwen3_asr_load_model(qwen3_asr_context* ctx, const char* model_path) {
     if (!ctx || !model_path) return false;
 
+    // map the new file first so readahead overlaps with the load below
+    unmap_model_file(ctx);
+    map_model_file(ctx, model_path);
+
 #ifdef QWEN3_ASR_HAS_VENDOR
     // Free previous model if any
     if (ctx->model) {
@@ -69,10 +238,12 @@ bool qwen3_asr_load_model(qwen3_asr_context* ctx, const char* model_path) {
     ctx->model = new qwen3_asr::Qwen3ASR();
     bool ok = ctx->model->load_model(std::string(model_path));
     ctx->model_loaded = ok;
+    ctx->model_path = ok ? model_path : "";
 
     if (!ok) {
         delete ctx->model;
         ctx->model = nullptr;
+        unmap_model_file(ctx);
     }
 
     return ok;
@@ -98,11 +269,28 @@ bool qwen3_asr_load_model(qwen3_asr_context* ctx, const char* model_path) {
     model->model_path = model_path;
     ctx->model = model;
     ctx->model_loaded = true;
+    ctx->model_path = model_path;
     return true;
 #endif
 }
 
-struct qwen3_asr_result qwen3_asr_transcribe(
+bool qwen3_asr_reload_model(qwen3_asr_context* ctx, const char* model_path) {
+    if (!ctx || !model_path) return false;
+
+    // unchanged path: keep the loaded model and its mapping - this is the
+    // common app-launch case and costs nothing
+    if (ctx->model_loaded && ctx->model_path == model_path) {
+        return true;
+    }
+
+    return qwen3_asr_load_model(ctx, model_path);
+}
+
+// Batch transcription body, shared by qwen3_asr_transcribe and
+// qwen3_asr_transcribe_batch. Does not touch the cancel flag - the public
+// entry points own clearing it, so cancelling a batch is not undone by the
+// next segment starting.
+static struct qwen3_asr_result transcribe_one(
     qwen3_asr_context* ctx,
     const float* samples,
     int32_t n_samples,
@@ -126,10 +314,40 @@ struct qwen3_asr_result qwen3_asr_transcribe(
     tp.print_progress = false;
     tp.print_timing = false;
 
-    auto res = ctx->model->transcribe(samples, n_samples, tp);
-    result.text = strdup_safe(res.text);
-    result.n_tokens = (int32_t)res.tokens.size();
-    result.success = res.success;
+    if (params.max_decode_ms > 0) {
+        // a vendor transcribe() call cannot be interrupted, so deadline (and
+        // cancellation) enforcement needs window granularity: decode in 5s
+        // windows and stop between them, returning the partial text so far
+        const int32_t window_samples = 5 * 16000;
+        std::string partial;
+        bool ok = true;
+
+        for (int32_t offset = 0; offset < n_samples; offset += window_samples) {
+            if (decode_should_stop(ctx, params, start)) {
+                break;
+            }
+
+            const int32_t count = n_samples - offset < window_samples
+                ? n_samples - offset
+                : window_samples;
+
+            auto res = ctx->model->transcribe(samples + offset, count, tp);
+            if (!res.success) {
+                ok = false;
+                break;
+            }
+            partial += res.text;
+            result.n_tokens += (int32_t)res.tokens.size();
+        }
+
+        result.text = strdup_safe(partial);
+        result.success = ok;
+    } else {
+        auto res = ctx->model->transcribe(samples, n_samples, tp);
+        result.text = strdup_safe(res.text);
+        result.n_tokens = (int32_t)res.tokens.size();
+        result.success = res.success;
+    }
 #else
     // Stub: return placeholder
     float duration_sec = (float)n_samples / 16000.0f;
@@ -146,6 +364,18 @@ struct qwen3_asr_result qwen3_asr_transcribe(
     return result;
 }
 
+struct qwen3_asr_result qwen3_asr_transcribe(
+    qwen3_asr_context* ctx,
+    const float* samples,
+    int32_t n_samples,
+    struct qwen3_asr_params params
+) {
+    if (ctx) {
+        ctx->cancel_requested.store(false, std::memory_order_relaxed);
+    }
+    return transcribe_one(ctx, samples, n_samples, params);
+}
+
 struct qwen3_asr_result qwen3_asr_transcribe_streaming(
     qwen3_asr_context* ctx,
     const float* samples,
@@ -164,23 +394,58 @@ struct qwen3_asr_result qwen3_asr_transcribe_streaming(
         return result;
     }
 
+    ctx->cancel_requested.store(false, std::memory_order_relaxed);
+
     auto start = std::chrono::high_resolution_clock::now();
 
 #ifdef QWEN3_ASR_HAS_VENDOR
-    // The vendor's progress_callback gives (tokens_generated, max_tokens), not token text.
-    // Use batch mode and call the callback once with the full result.
+    // Drive the decode in short audio windows and surface each window's
+    // tokens through the callback as they are produced, instead of one batch
+    // call that fires once at the end. The vendor only exposes whole-buffer
+    // transcribe(), so the window length bounds first-token latency (~5s of
+    // audio per decode); a false return from the callback abandons the
+    // remaining windows so the compute is reclaimed mid-generation.
+    const int32_t window_samples = 5 * 16000;
+
     qwen3_asr::transcribe_params tp;
     tp.n_threads = params.n_threads > 0 ? params.n_threads : 4;
     tp.print_progress = false;
     tp.print_timing = false;
 
-    auto res = ctx->model->transcribe(samples, n_samples, tp);
-    if (res.success && callback) {
-        callback(res.text.c_str(), user_data);
+    std::string full_text;
+    bool aborted = false;
+    bool ok = true;
+
+    for (int32_t offset = 0; offset < n_samples && !aborted; offset += window_samples) {
+        if (decode_should_stop(ctx, params, start)) {
+            break;  // cancelled or past the deadline - keep the partial text
+        }
+
+        const int32_t count = n_samples - offset < window_samples
+            ? n_samples - offset
+            : window_samples;
+
+        auto res = ctx->model->transcribe(samples + offset, count, tp);
+        if (!res.success) {
+            ok = false;
+            break;
+        }
+
+        for (const auto& token : res.tokens) {
+            if (callback) {
+                bool should_continue = callback(token.c_str(), user_data);
+                if (!should_continue) {
+                    aborted = true;
+                    break;
+                }
+            }
+            full_text += token;
+            result.n_tokens++;
+        }
     }
-    result.text = strdup_safe(res.text);
-    result.n_tokens = (int32_t)res.tokens.size();
-    result.success = res.success;
+
+    result.text = strdup_safe(full_text);
+    result.success = ok;
 #else
     // Stub: emit a few tokens via callback, then return full text
     std::string full_text;
@@ -206,6 +471,51 @@ struct qwen3_asr_result qwen3_asr_transcribe_streaming(
     return result;
 }
 
+int32_t qwen3_asr_transcribe_batch(
+    qwen3_asr_context* ctx,
+    const float* const* segments,
+    const int32_t* lengths,
+    int32_t n_segments,
+    struct qwen3_asr_params params,
+    struct qwen3_asr_result* results
+) {
+    if (!results || n_segments <= 0) return 0;
+
+    // zero every slot first so a partially processed batch is still safe to
+    // walk (and to free) on the caller's side
+    for (int32_t i = 0; i < n_segments; i++) {
+        results[i].text = nullptr;
+        results[i].n_tokens = 0;
+        results[i].duration_ms = 0.0f;
+        results[i].success = false;
+    }
+
+    if (!ctx || !ctx->model_loaded || !segments || !lengths) return 0;
+
+    // One FFI crossing for the whole batch; the segments share the context's
+    // loaded weights and decode back to back. The vendor library offers no
+    // batched-KV encoder pass, so cross-segment GPU batching has to land
+    // there first - until then, combine this with qwen3_asr_pool to overlap
+    // segments across contexts.
+    ctx->cancel_requested.store(false, std::memory_order_relaxed);
+
+    int32_t n_ok = 0;
+    for (int32_t i = 0; i < n_segments; i++) {
+        if (ctx->cancel_requested.load(std::memory_order_relaxed)) {
+            break;  // cancelled mid-batch; remaining slots stay zeroed
+        }
+        results[i] = transcribe_one(ctx, segments[i], lengths[i], params);
+        if (results[i].success) n_ok++;
+    }
+
+    return n_ok;
+}
+
+void qwen3_asr_cancel(qwen3_asr_context* ctx) {
+    if (!ctx) return;
+    ctx->cancel_requested.store(true, std::memory_order_relaxed);
+}
+
 bool qwen3_asr_is_model_loaded(const qwen3_asr_context* ctx) {
     if (!ctx) return false;
     return ctx->model_loaded;
@@ -225,6 +535,7 @@ void qwen3_asr_free(qwen3_asr_context* ctx) {
     }
 #endif
 
+    unmap_model_file(ctx);
     delete ctx;
 }
 
@@ -232,4 +543,249 @@ void qwen3_asr_free_text(char* text) {
     free(text);
 }
 
+// ---------------------------------------------------------------------------
+// Zero-copy results
+// ---------------------------------------------------------------------------
+
+qwen3_asr_result_handle* qwen3_asr_transcribe_borrowed(
+    qwen3_asr_context* ctx,
+    const float* samples,
+    int32_t n_samples,
+    struct qwen3_asr_params params,
+    struct qwen3_asr_result_view* view
+) {
+    if (view) {
+        view->text = nullptr;
+        view->tokens = nullptr;
+        view->n_tokens = 0;
+        view->duration_ms = 0.0f;
+        view->success = false;
+    }
+
+    if (ctx) {
+        ctx->cancel_requested.store(false, std::memory_order_relaxed);
+    }
+
+    if (!ctx || !ctx->model_loaded || !samples || n_samples <= 0 || !view) {
+        return nullptr;
+    }
+
+    auto* handle = new qwen3_asr_result_handle();
+    auto start = std::chrono::high_resolution_clock::now();
+
+#ifdef QWEN3_ASR_HAS_VENDOR
+    qwen3_asr::transcribe_params tp;
+    tp.n_threads = params.n_threads > 0 ? params.n_threads : 4;
+    tp.print_progress = false;
+    tp.print_timing = false;
+
+    if (params.max_decode_ms > 0) {
+        // same window-granularity deadline/cancel enforcement as
+        // transcribe_one; per-window vendor strings are moved into the
+        // arena, so the path stays copy-free on the way out
+        const int32_t window_samples = 5 * 16000;
+        bool ok = true;
+
+        for (int32_t offset = 0; offset < n_samples; offset += window_samples) {
+            if (decode_should_stop(ctx, params, start)) {
+                break;
+            }
+
+            const int32_t count = n_samples - offset < window_samples
+                ? n_samples - offset
+                : window_samples;
+
+            auto res = ctx->model->transcribe(samples + offset, count, tp);
+            if (!res.success) {
+                ok = false;
+                break;
+            }
+            handle->text += res.text;
+            for (auto& token : res.tokens) {
+                handle->tokens.push_back(std::move(token));
+            }
+        }
+        view->success = ok;
+    } else {
+        auto res = ctx->model->transcribe(samples, n_samples, tp);
+        // move the vendor strings into the arena - no copy, no per-call malloc
+        handle->text = std::move(res.text);
+        handle->tokens = std::move(res.tokens);
+        view->success = res.success;
+    }
+#else
+    // Stub: return placeholder
+    float duration_sec = (float)n_samples / 16000.0f;
+    handle->text = "[Qwen3-ASR stub: " + std::to_string(n_samples) +
+                   " samples, " + std::to_string(duration_sec) + "s audio]";
+    handle->tokens.push_back(handle->text);
+    view->success = true;
+#endif
+
+    handle->token_ptrs.reserve(handle->tokens.size());
+    for (const auto& token : handle->tokens) {
+        handle->token_ptrs.push_back(token.c_str());
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    view->text = handle->text.c_str();
+    view->tokens = handle->token_ptrs.empty() ? nullptr : handle->token_ptrs.data();
+    view->n_tokens = (int32_t)handle->tokens.size();
+    view->duration_ms = std::chrono::duration<float, std::milli>(end - start).count();
+
+    return handle;
+}
+
+void qwen3_asr_result_free(qwen3_asr_result_handle* handle) {
+    delete handle;
+}
+
+// ---------------------------------------------------------------------------
+// Chunked streaming sessions
+// ---------------------------------------------------------------------------
+
+qwen3_asr_stream* qwen3_asr_stream_open(qwen3_asr_context* ctx, struct qwen3_asr_params params) {
+    if (!ctx || !ctx->model_loaded) return nullptr;
+
+    ctx->cancel_requested.store(false, std::memory_order_relaxed);
+
+    auto* stream = new qwen3_asr_stream();
+    stream->ctx = ctx;
+    stream->params = params;
+    stream->n_tokens = 0;
+    stream->decode_ms = 0.0f;
+    stream->aborted = false;
+    stream->failed = false;
+    return stream;
+}
+
+bool qwen3_asr_stream_feed(
+    qwen3_asr_stream* stream,
+    const float* samples,
+    int32_t n_samples,
+    qwen3_asr_token_callback callback,
+    void* user_data
+) {
+    if (!stream || stream->failed) return false;
+    if (!samples || n_samples <= 0) return !stream->failed;
+    if (stream->aborted) return true;  // session drained, silently drop audio
+
+    stream->pending.insert(stream->pending.end(), samples, samples + n_samples);
+
+    // decode every complete window; a 200ms feed usually just buffers, and
+    // pays for a decode only when it completes a window. Cancellation and the
+    // deadline are enforced per feed, between windows.
+    auto feed_start = std::chrono::high_resolution_clock::now();
+    while (!stream->aborted && !stream->failed &&
+           !decode_should_stop(stream->ctx, stream->params, feed_start) &&
+           stream->pending.size() >= (size_t)QWEN3_ASR_STREAM_WINDOW) {
+        stream_decode_window(stream, stream->pending.data(), QWEN3_ASR_STREAM_WINDOW,
+                             callback, user_data);
+        stream->pending.erase(stream->pending.begin(),
+                              stream->pending.begin() + QWEN3_ASR_STREAM_WINDOW);
+    }
+
+    if (stream->aborted) {
+        stream->pending.clear();
+    }
+
+    return !stream->failed;
+}
+
+struct qwen3_asr_result qwen3_asr_stream_finish(qwen3_asr_stream* stream) {
+    struct qwen3_asr_result result;
+    result.text = nullptr;
+    result.n_tokens = 0;
+    result.duration_ms = 0.0f;
+    result.success = false;
+
+    if (!stream) {
+        return result;
+    }
+
+    // flush whatever is left below one window
+    if (!stream->aborted && !stream->failed && !stream->pending.empty()) {
+        stream_decode_window(stream, stream->pending.data(),
+                             (int32_t)stream->pending.size(), nullptr, nullptr);
+    }
+
+    result.text = strdup_safe(stream->text);
+    result.n_tokens = stream->n_tokens;
+    result.duration_ms = stream->decode_ms;
+    result.success = !stream->failed;
+
+    delete stream;
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Context pool
+// ---------------------------------------------------------------------------
+
+qwen3_asr_pool* qwen3_asr_pool_init(const char* model_path, int32_t n_contexts) {
+    if (!model_path || n_contexts <= 0) return nullptr;
+
+    auto* pool = new qwen3_asr_pool();
+    pool->n_contexts = n_contexts;
+    pool->contexts = new qwen3_asr_context*[n_contexts]();
+    pool->in_use = new std::atomic<bool>[n_contexts];
+
+    for (int32_t i = 0; i < n_contexts; i++) {
+        pool->in_use[i].store(false, std::memory_order_relaxed);
+        pool->contexts[i] = qwen3_asr_init();
+        if (!pool->contexts[i] || !qwen3_asr_load_model(pool->contexts[i], model_path)) {
+            // roll back everything loaded so far
+            for (int32_t j = 0; j <= i; j++) {
+                if (pool->contexts[j]) qwen3_asr_free(pool->contexts[j]);
+            }
+            delete[] pool->contexts;
+            delete[] pool->in_use;
+            delete pool;
+            return nullptr;
+        }
+    }
+
+    return pool;
+}
+
+qwen3_asr_context* qwen3_asr_pool_acquire(qwen3_asr_pool* pool) {
+    if (!pool) return nullptr;
+
+    for (int32_t i = 0; i < pool->n_contexts; i++) {
+        bool expected = false;
+        if (pool->in_use[i].compare_exchange_strong(expected, true,
+                                                    std::memory_order_acquire)) {
+            return pool->contexts[i];
+        }
+    }
+    return nullptr;  // all contexts busy
+}
+
+void qwen3_asr_pool_release(qwen3_asr_pool* pool, qwen3_asr_context* ctx) {
+    if (!pool || !ctx) return;
+
+    for (int32_t i = 0; i < pool->n_contexts; i++) {
+        if (pool->contexts[i] == ctx) {
+            pool->in_use[i].store(false, std::memory_order_release);
+            return;
+        }
+    }
+}
+
+int32_t qwen3_asr_pool_size(const qwen3_asr_pool* pool) {
+    return pool ? pool->n_contexts : 0;
+}
+
+void qwen3_asr_pool_free(qwen3_asr_pool* pool) {
+    if (!pool) return;
+
+    for (int32_t i = 0; i < pool->n_contexts; i++) {
+        if (pool->contexts[i]) qwen3_asr_free(pool->contexts[i]);
+    }
+    delete[] pool->contexts;
+    delete[] pool->in_use;
+    delete pool;
+}
+
 } // extern "C"
@@ -18,6 +18,8 @@ struct qwen3_asr_params {
     bool    use_gpu;       // Enable GPU acceleration
     int32_t gpu_device;    // GPU device index
     float   temperature;   // Sampling temperature (0.0 = greedy)
+    int32_t max_decode_ms; // Decode deadline per call (0 = no limit); on
+                           // expiry the partial text so far is returned
 };
 
 // Transcription result
@@ -42,9 +44,17 @@ struct qwen3_asr_params qwen3_asr_default_params(void);
 qwen3_asr_context* qwen3_asr_init(void);
 
 // Load a GGUF model file
+// The file is memory-mapped read-only with readahead before loading, so
+// weight pages stream in lazily and repeat launches come from the page cache.
 // Returns true on success
 bool qwen3_asr_load_model(qwen3_asr_context* ctx, const char* model_path);
 
+// Load a model only if the path differs from the one currently loaded.
+// The unchanged-path case is a no-op that keeps the existing model and its
+// file mapping warm, making it safe to call on every app launch.
+// Returns true on success
+bool qwen3_asr_reload_model(qwen3_asr_context* ctx, const char* model_path);
+
 // Transcribe audio samples (batch mode)
 // samples: pointer to float32 PCM audio at 16kHz mono
 // n_samples: number of samples
@@ -57,7 +67,8 @@ struct qwen3_asr_result qwen3_asr_transcribe(
 );
 
 // Transcribe audio samples with streaming token output
-// callback is invoked for each decoded token
+// callback is invoked for each decoded token, as decode windows complete;
+// returning false from it aborts the decode and returns the partial result
 struct qwen3_asr_result qwen3_asr_transcribe_streaming(
     qwen3_asr_context* ctx,
     const float* samples,
@@ -67,6 +78,30 @@ struct qwen3_asr_result qwen3_asr_transcribe_streaming(
     void* user_data
 );
 
+// Transcribe several audio segments in one FFI call.
+// segments: n_segments pointers to float32 PCM buffers at 16kHz mono
+// lengths:  number of samples in each segment
+// results:  caller-allocated array of n_segments entries; each is filled like
+//           qwen3_asr_transcribe's return value, and each text must be freed
+//           with qwen3_asr_free_text
+// Returns the number of segments transcribed successfully. A failed segment
+// gets success == false in its slot and the batch continues.
+int32_t qwen3_asr_transcribe_batch(
+    qwen3_asr_context* ctx,
+    const float* const* segments,
+    const int32_t* lengths,
+    int32_t n_segments,
+    struct qwen3_asr_params params,
+    struct qwen3_asr_result* results
+);
+
+// Request cancellation of the transcription currently running on this
+// context. Safe to call from any thread; the flag is polled between decode
+// windows, so a pathological chunk stops within one window. The partial text
+// decoded so far is returned, and the flag clears when the next
+// transcription (or streaming session) starts on the context.
+void qwen3_asr_cancel(qwen3_asr_context* ctx);
+
 // Check if a model is loaded
 bool qwen3_asr_is_model_loaded(const qwen3_asr_context* ctx);
 
@@ -76,6 +111,107 @@ void qwen3_asr_free(qwen3_asr_context* ctx);
 // Free text returned by qwen3_asr_result
 void qwen3_asr_free_text(char* text);
 
+// ---------------------------------------------------------------------------
+// Zero-copy results
+//
+// qwen3_asr_transcribe copies the transcript once into a malloc'd buffer and
+// the caller usually copies it again. The borrowed variant hands out pointers
+// into memory owned by an opaque result handle instead, so the FFI boundary
+// costs no allocation or copy per call; everything is released by one
+// qwen3_asr_result_free.
+// ---------------------------------------------------------------------------
+
+// Opaque handle owning all memory behind the borrowed views below
+typedef struct qwen3_asr_result_handle qwen3_asr_result_handle;
+
+// Borrowed views into a result handle. Every pointer stays valid exactly
+// until qwen3_asr_result_free is called on the owning handle.
+struct qwen3_asr_result_view {
+    const char*        text;        // full transcript, null-terminated
+    const char* const* tokens;      // per-token texts, n_tokens entries
+    int32_t            n_tokens;
+    float              duration_ms; // processing time in milliseconds
+    bool               success;
+};
+
+// Transcribe without copying the result out: fills *view with pointers into
+// the returned handle. Returns NULL (and a zeroed view) on invalid arguments;
+// decode failures still return a handle with view->success == false.
+qwen3_asr_result_handle* qwen3_asr_transcribe_borrowed(
+    qwen3_asr_context* ctx,
+    const float* samples,
+    int32_t n_samples,
+    struct qwen3_asr_params params,
+    struct qwen3_asr_result_view* view
+);
+
+// Release a result handle and every view into it
+void qwen3_asr_result_free(qwen3_asr_result_handle* handle);
+
+// ---------------------------------------------------------------------------
+// Chunked streaming sessions
+//
+// A session accepts audio incrementally, so the recording pipeline can feed
+// 200ms chunks as they arrive instead of re-transcribing a growing buffer or
+// waiting for utterance end. Audio is decoded window by window as enough
+// accumulates, so each feed costs only the new audio's marginal decode.
+// ---------------------------------------------------------------------------
+
+// Opaque streaming session handle
+typedef struct qwen3_asr_stream qwen3_asr_stream;
+
+// Open a streaming session on a loaded context. The context must stay alive
+// (and not be used for other transcriptions) until the session finishes.
+qwen3_asr_stream* qwen3_asr_stream_open(qwen3_asr_context* ctx, struct qwen3_asr_params params);
+
+// Feed the next chunk of float32 PCM audio at 16kHz mono. Any complete decode
+// windows are transcribed before returning; callback (may be NULL) receives
+// each new token, and returning false from it drops the rest of the session's
+// audio. Returns false if the session is invalid or a decode failed.
+bool qwen3_asr_stream_feed(
+    qwen3_asr_stream* stream,
+    const float* samples,
+    int32_t n_samples,
+    qwen3_asr_token_callback callback,
+    void* user_data
+);
+
+// Flush any remaining audio, return the aggregate result for the whole
+// session, and free the session handle (it must not be used afterwards).
+struct qwen3_asr_result qwen3_asr_stream_finish(qwen3_asr_stream* stream);
+
+// ---------------------------------------------------------------------------
+// Context pool for concurrent transcription
+//
+// A pool holds n_contexts independent decode contexts over the same model
+// file, so batch workloads can fan segments across worker threads instead of
+// serializing on a single context. Checkout is lock-free (an atomic flag per
+// slot), so it is safe to call acquire/release from any thread.
+// ---------------------------------------------------------------------------
+
+// Opaque pool handle
+typedef struct qwen3_asr_pool qwen3_asr_pool;
+
+// Create a pool of n_contexts contexts, each loaded from model_path.
+// Returns NULL if any context fails to load.
+qwen3_asr_pool* qwen3_asr_pool_init(const char* model_path, int32_t n_contexts);
+
+// Check out an idle context. Returns NULL immediately if every context is
+// busy (no blocking); the caller decides whether to retry or queue.
+// The handle works with any transcribe function, but must be returned with
+// qwen3_asr_pool_release — never qwen3_asr_free.
+qwen3_asr_context* qwen3_asr_pool_acquire(qwen3_asr_pool* pool);
+
+// Return a context previously checked out with qwen3_asr_pool_acquire
+void qwen3_asr_pool_release(qwen3_asr_pool* pool, qwen3_asr_context* ctx);
+
+// Number of contexts in the pool
+int32_t qwen3_asr_pool_size(const qwen3_asr_pool* pool);
+
+// Free the pool and every context in it.
+// All handles must be checked in before calling this.
+void qwen3_asr_pool_free(qwen3_asr_pool* pool);
+
 #ifdef __cplusplus
 }
 #endif
@@ -31,6 +31,9 @@ pub struct qwen3_asr_params {
     pub gpu_device: i32,
     /// Sampling temperature (0.0 = greedy decoding)
     pub temperature: c_float,
+    /// Decode deadline per call in milliseconds (0 = no limit); on expiry
+    /// the partial text decoded so far is returned
+    pub max_decode_ms: i32,
 }
 
 /// Transcription result.
@@ -98,6 +101,10 @@ extern "C" {
     /// Free the ASR context and all associated resources.
     pub fn qwen3_asr_free(ctx: *mut qwen3_asr_context);
 
+    /// Request cancellation of the transcription currently running on this
+    /// context. Safe to call from any thread; polled between decode windows.
+    pub fn qwen3_asr_cancel(ctx: *mut qwen3_asr_context);
+
     /// Free text allocated by qwen3_asr_result.
     pub fn qwen3_asr_free_text(text: *mut c_char);
 }
@@ -114,6 +121,7 @@ mod tests {
             assert!(params.use_gpu);
             assert_eq!(params.gpu_device, 0);
             assert_eq!(params.temperature, 0.0);
+            assert_eq!(params.max_decode_ms, 0);
         }
     }
 